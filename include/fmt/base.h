@@ -296,6 +296,11 @@ FMT_PRAGMA_GCC(diagnostic push)
 #  define FMT_BUILTIN_TYPES 1
 #endif
 
+// The number of code units buffered before writing to an output iterator.
+#ifndef FMT_ITERATOR_BUFFER_SIZE
+#  define FMT_ITERATOR_BUFFER_SIZE 256
+#endif
+
 #define FMT_APPLY_VARIADIC(expr) \
   using unused = int[];          \
   (void)unused { 0, (expr, 0)... }
@@ -1880,6 +1885,110 @@ template <typename T> class buffer {
   }
 };
 
+template <typename T>
+struct is_back_insert_iterator<basic_appender<T>> : std::true_type {};
+
+template <typename OutputIt, typename InputIt, typename = void>
+struct has_back_insert_iterator_container_append : std::false_type {};
+template <typename OutputIt, typename InputIt>
+struct has_back_insert_iterator_container_append<
+    OutputIt, InputIt,
+    void_t<decltype(get_container(std::declval<OutputIt>())
+                        .append(std::declval<InputIt>(),
+                                std::declval<InputIt>()))>> : std::true_type {};
+
+template <typename OutputIt, typename InputIt, typename = void>
+struct has_back_insert_iterator_container_insert_at_end : std::false_type {};
+
+template <typename OutputIt, typename InputIt>
+struct has_back_insert_iterator_container_insert_at_end<
+    OutputIt, InputIt,
+    void_t<decltype(get_container(std::declval<OutputIt>())
+                        .insert(get_container(std::declval<OutputIt>()).end(),
+                                std::declval<InputIt>(),
+                                std::declval<InputIt>()))>> : std::true_type {};
+
+// An optimized version of std::copy with the output value type (T).
+template <typename T, typename InputIt, typename OutputIt,
+          FMT_ENABLE_IF(is_back_insert_iterator<OutputIt>::value&&
+                            has_back_insert_iterator_container_append<
+                                OutputIt, InputIt>::value)>
+FMT_CONSTEXPR20 auto copy(InputIt begin, InputIt end, OutputIt out)
+    -> OutputIt {
+  get_container(out).append(begin, end);
+  return out;
+}
+
+template <typename T, typename InputIt, typename OutputIt,
+          FMT_ENABLE_IF(is_back_insert_iterator<OutputIt>::value &&
+                        !has_back_insert_iterator_container_append<
+                            OutputIt, InputIt>::value &&
+                        has_back_insert_iterator_container_insert_at_end<
+                            OutputIt, InputIt>::value)>
+FMT_CONSTEXPR20 auto copy(InputIt begin, InputIt end, OutputIt out)
+    -> OutputIt {
+  auto& c = get_container(out);
+  c.insert(c.end(), begin, end);
+  return out;
+}
+
+template <typename T, typename InputIt, typename OutputIt,
+          FMT_ENABLE_IF(!(is_back_insert_iterator<OutputIt>::value &&
+                          (has_back_insert_iterator_container_append<
+                               OutputIt, InputIt>::value ||
+                           has_back_insert_iterator_container_insert_at_end<
+                               OutputIt, InputIt>::value)))>
+FMT_CONSTEXPR auto copy(InputIt begin, InputIt end, OutputIt out) -> OutputIt {
+  while (begin != end) *out++ = static_cast<T>(*begin++);
+  return out;
+}
+
+template <typename T, typename V, typename OutputIt>
+FMT_CONSTEXPR auto copy(basic_string_view<V> s, OutputIt out) -> OutputIt {
+  return copy<T>(s.begin(), s.end(), out);
+}
+
+template <typename OutputIt, typename T, typename = void>
+struct has_bulk_append : std::false_type {};
+template <typename OutputIt, typename T>
+struct has_bulk_append<
+    OutputIt, T,
+    void_t<decltype(bulk_append(std::declval<OutputIt&>(),
+                                std::declval<const T*>(), size_t()))>>
+    : std::true_type {};
+
+// Writes n elements starting at data to out. An output iterator can
+// customize this with a bulk_append(OutputIt, const T*, size_t) function
+// found by argument-dependent lookup that returns the advanced iterator.
+// Otherwise back insert iterators use append or a range insert of the
+// container if available and other iterators are written one element at a
+// time.
+template <typename T, typename OutputIt,
+          FMT_ENABLE_IF(has_bulk_append<OutputIt, T>::value)>
+void write_chunk(OutputIt& out, const T* data, size_t n) {
+  out = bulk_append(out, data, n);
+}
+template <typename T, typename OutputIt,
+          FMT_ENABLE_IF(!has_bulk_append<OutputIt, T>::value &&
+                        is_back_insert_iterator<OutputIt>::value &&
+                        (has_back_insert_iterator_container_append<
+                             OutputIt, const T*>::value ||
+                         has_back_insert_iterator_container_insert_at_end<
+                             OutputIt, const T*>::value))>
+void write_chunk(OutputIt& out, const T* data, size_t n) {
+  copy<T>(data, data + n, out);
+}
+template <typename T, typename OutputIt,
+          FMT_ENABLE_IF(!has_bulk_append<OutputIt, T>::value &&
+                        !(is_back_insert_iterator<OutputIt>::value &&
+                          (has_back_insert_iterator_container_append<
+                               OutputIt, const T*>::value ||
+                           has_back_insert_iterator_container_insert_at_end<
+                               OutputIt, const T*>::value)))>
+void write_chunk(OutputIt& out, const T* data, size_t n) {
+  for (size_t i = 0; i < n; ++i) *out++ = data[i];
+}
+
 struct buffer_traits {
   constexpr explicit buffer_traits(size_t) {}
   constexpr auto count() const -> size_t { return 0; }
@@ -1906,7 +2015,7 @@ template <typename OutputIt, typename T, typename Traits = buffer_traits>
 class iterator_buffer : public Traits, public buffer<T> {
  private:
   OutputIt out_;
-  enum { buffer_size = 256 };
+  enum { buffer_size = FMT_ITERATOR_BUFFER_SIZE };
   T data_[buffer_size];
 
   static FMT_CONSTEXPR void grow(buffer<T>& buf, size_t) {
@@ -1916,9 +2025,8 @@ class iterator_buffer : public Traits, public buffer<T> {
   void flush() {
     auto size = this->size();
     this->clear();
-    const T* begin = data_;
-    const T* end = begin + this->limit(size);
-    while (begin != end) *out_++ = *begin++;
+    size_t n = this->limit(size);
+    if (n != 0) write_chunk<T>(out_, data_, n);
   }
 
  public:
@@ -2052,69 +2160,6 @@ template <typename T = char> class counting_buffer : public buffer<T> {
   }
 };
 
-template <typename T>
-struct is_back_insert_iterator<basic_appender<T>> : std::true_type {};
-
-template <typename OutputIt, typename InputIt, typename = void>
-struct has_back_insert_iterator_container_append : std::false_type {};
-template <typename OutputIt, typename InputIt>
-struct has_back_insert_iterator_container_append<
-    OutputIt, InputIt,
-    void_t<decltype(get_container(std::declval<OutputIt>())
-                        .append(std::declval<InputIt>(),
-                                std::declval<InputIt>()))>> : std::true_type {};
-
-template <typename OutputIt, typename InputIt, typename = void>
-struct has_back_insert_iterator_container_insert_at_end : std::false_type {};
-
-template <typename OutputIt, typename InputIt>
-struct has_back_insert_iterator_container_insert_at_end<
-    OutputIt, InputIt,
-    void_t<decltype(get_container(std::declval<OutputIt>())
-                        .insert(get_container(std::declval<OutputIt>()).end(),
-                                std::declval<InputIt>(),
-                                std::declval<InputIt>()))>> : std::true_type {};
-
-// An optimized version of std::copy with the output value type (T).
-template <typename T, typename InputIt, typename OutputIt,
-          FMT_ENABLE_IF(is_back_insert_iterator<OutputIt>::value&&
-                            has_back_insert_iterator_container_append<
-                                OutputIt, InputIt>::value)>
-FMT_CONSTEXPR20 auto copy(InputIt begin, InputIt end, OutputIt out)
-    -> OutputIt {
-  get_container(out).append(begin, end);
-  return out;
-}
-
-template <typename T, typename InputIt, typename OutputIt,
-          FMT_ENABLE_IF(is_back_insert_iterator<OutputIt>::value &&
-                        !has_back_insert_iterator_container_append<
-                            OutputIt, InputIt>::value &&
-                        has_back_insert_iterator_container_insert_at_end<
-                            OutputIt, InputIt>::value)>
-FMT_CONSTEXPR20 auto copy(InputIt begin, InputIt end, OutputIt out)
-    -> OutputIt {
-  auto& c = get_container(out);
-  c.insert(c.end(), begin, end);
-  return out;
-}
-
-template <typename T, typename InputIt, typename OutputIt,
-          FMT_ENABLE_IF(!(is_back_insert_iterator<OutputIt>::value &&
-                          (has_back_insert_iterator_container_append<
-                               OutputIt, InputIt>::value ||
-                           has_back_insert_iterator_container_insert_at_end<
-                               OutputIt, InputIt>::value)))>
-FMT_CONSTEXPR auto copy(InputIt begin, InputIt end, OutputIt out) -> OutputIt {
-  while (begin != end) *out++ = static_cast<T>(*begin++);
-  return out;
-}
-
-template <typename T, typename V, typename OutputIt>
-FMT_CONSTEXPR auto copy(basic_string_view<V> s, OutputIt out) -> OutputIt {
-  return copy<T>(s.begin(), s.end(), out);
-}
-
 template <typename It, typename Enable = std::true_type>
 struct is_buffer_appender : std::false_type {};
 template <typename It>
@@ -2499,6 +2544,39 @@ template <typename T> class basic_appender {
   FMT_CONSTEXPR20 auto operator++(int) -> basic_appender { return *this; }
 };
 
+namespace detail {
+// Returns a pointer to space for n code units at the end of the output or
+// null if the output is not contiguous. The space is not a part of the output
+// until commit_output is called.
+template <typename T, typename OutputIt>
+constexpr auto reserve_output(OutputIt&, size_t) -> T* {
+  return nullptr;
+}
+template <typename T>
+FMT_CONSTEXPR20 auto reserve_output(basic_appender<T>& it, size_t n) -> T* {
+  buffer<T>& buf = get_container(it);
+  buf.try_reserve(buf.size() + n);
+  return buf.capacity() - buf.size() >= n ? buf.end() : nullptr;
+}
+template <typename T>
+constexpr auto reserve_output(T*& ptr, size_t) -> T* {
+  return ptr;
+}
+
+template <typename T, typename OutputIt>
+FMT_CONSTEXPR void commit_output(OutputIt&, T*) {}
+template <typename T>
+FMT_CONSTEXPR20 void commit_output(basic_appender<T>& it, T* end) {
+  buffer<T>& buf = get_container(it);
+  FMT_ASSERT(end >= buf.end() && end <= buf.data() + buf.capacity(),
+             "invalid end of output");
+  buf.try_resize(to_unsigned(end - buf.data()));
+}
+template <typename T> FMT_CONSTEXPR void commit_output(T*& ptr, T* end) {
+  ptr = end;
+}
+}  // namespace detail
+
 // A formatting argument. Context is a template parameter for the compiled API
 // where output can be unbuffered.
 template <typename Context> class basic_format_arg {
@@ -2716,6 +2794,31 @@ class context {
   FMT_CONSTEXPR void advance_to(iterator) {}
 
   FMT_CONSTEXPR auto locale() const -> locale_ref { return loc_; }
+
+  /**
+   * Returns a pointer to space for `n` characters at the end of the output or
+   * null if there is not enough space, e.g. when the output is written to a
+   * fixed-size buffer. Characters written to this space become a part of the
+   * output after a call to `commit`. Nothing else may be written to the
+   * output in between.
+   *
+   * **Example**:
+   *
+   *     if (char* p = ctx.reserve(max_size)) {
+   *       ctx.commit(write_id(p, id));
+   *       return ctx.out();
+   *     }
+   *     return fmt::format_to(ctx.out(), "{}", id);
+   */
+  FMT_CONSTEXPR20 auto reserve(size_t n) -> char* {
+    return detail::reserve_output<char>(out_, n);
+  }
+
+  /// Completes the write started with `reserve`. `end` points past the last
+  /// written character.
+  FMT_CONSTEXPR20 void commit(char* end) {
+    detail::commit_output<char>(out_, end);
+  }
 };
 
 template <typename Char = char> struct runtime_format_string {
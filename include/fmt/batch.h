@@ -0,0 +1,288 @@
+// Formatting library for C++ - parallel batch formatting
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+
+#ifndef FMT_BATCH_H_
+#define FMT_BATCH_H_
+
+#ifndef FMT_MODULE
+#  include <atomic>
+#  include <condition_variable>
+#  include <cstdio>
+#  include <exception>
+#  include <mutex>
+#  include <thread>
+#  include <tuple>
+#  include <vector>
+#endif
+
+#include "ranges.h"  // detail::tuple_index_sequence
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+// A format string that is parsed once and then applied to many argument
+// lists. Parsing events are recorded while formatting the first argument
+// list and replayed for the others so that only format specs are parsed
+// again.
+class batch_format {
+ private:
+  enum class event_kind { text, field, field_with_specs };
+
+  struct event {
+    event_kind kind;
+    bool auto_id;  // The argument id has been assigned automatically.
+    int id;
+    const char* begin;
+    const char* end;
+  };
+
+  string_view fmt_;
+  std::vector<event> events_;
+
+  struct recorder {
+    format_handler<> handler;
+    std::vector<event>& events;
+    bool auto_id;
+
+    void on_text(const char* begin, const char* end) {
+      events.push_back({event_kind::text, false, 0, begin, end});
+      handler.on_text(begin, end);
+    }
+    auto on_arg_id() -> int {
+      auto_id = true;
+      return handler.on_arg_id();
+    }
+    auto on_arg_id(int id) -> int {
+      auto_id = false;
+      return handler.on_arg_id(id);
+    }
+    auto on_arg_id(string_view id) -> int {
+      auto_id = false;
+      return handler.on_arg_id(id);
+    }
+    void on_replacement_field(int id, const char* begin) {
+      events.push_back({event_kind::field, auto_id, id, begin, begin});
+      handler.on_replacement_field(id, begin);
+    }
+    auto on_format_specs(int id, const char* begin, const char* end)
+        -> const char* {
+      auto specs_end = handler.on_format_specs(id, begin, end);
+      events.push_back(
+          {event_kind::field_with_specs, auto_id, id, begin, specs_end});
+      return specs_end;
+    }
+    FMT_NORETURN void on_error(const char* message) { report_error(message); }
+  };
+
+ public:
+  explicit batch_format(string_view fmt) : fmt_(fmt) {}
+
+  // Formats `args` and records the parsing events. It must be called once
+  // before format.
+  void record(buffer<char>& buf, format_args args) {
+    events_.clear();
+    parse_format_string(
+        fmt_, recorder{{parse_context<>(fmt_), {appender(buf), args, {}}},
+                       events_,
+                       false});
+  }
+
+  void format(buffer<char>& buf, format_args args) const {
+    auto handler =
+        format_handler<>{parse_context<>(fmt_), {appender(buf), args, {}}};
+    for (const event& e : events_) {
+      switch (e.kind) {
+      case event_kind::text:
+        handler.on_text(e.begin, e.end);
+        break;
+      case event_kind::field:
+        if (e.auto_id) handler.on_arg_id();
+        handler.on_replacement_field(e.id, e.begin);
+        break;
+      case event_kind::field_with_specs:
+        // Advance the parse context in the same way as on the first pass
+        // for automatic indexing of nested replacement fields.
+        if (e.auto_id) handler.on_arg_id();
+        handler.on_format_specs(e.id, e.begin, fmt_.end());
+        break;
+      }
+    }
+  }
+};
+
+template <typename Tuple, size_t... N>
+auto row_args(const Tuple& row, index_sequence<N...>)
+    -> decltype(fmt::make_format_args(std::get<N>(row)...)) {
+  return fmt::make_format_args(std::get<N>(row)...);
+}
+
+inline void batch_write(std::FILE* f, string_view s, int) {
+  if (std::fwrite(s.data(), 1, s.size(), f) < s.size())
+    FMT_THROW(system_error(errno, "cannot write to file"));
+}
+
+// Writes to fmt::ostream and other types with a print member function.
+template <typename Sink>
+auto batch_write(Sink& sink, string_view s, int)
+    -> decltype(sink.print("{}", s)) {
+  sink.print("{}", s);
+}
+
+template <typename Sink> void batch_write(Sink& sink, string_view s, ...) {
+  sink(s);
+}
+
+// Formats `num_rows` rows in chunks on worker threads. Formatted chunks are
+// kept in a ring of buffers that bounds the number of chunks formatted ahead
+// of the one being written and are passed to `write` in order.
+template <typename FormatChunk, typename Write>
+void run_batch(size_t num_chunks, unsigned num_threads,
+               FormatChunk format_chunk, Write write) {
+  struct slot {
+    memory_buffer buf;
+    bool ready = false;
+  };
+  size_t window = 2 * size_t(num_threads);
+  auto slots = std::vector<slot>(window);
+  auto mutex = std::mutex();
+  auto chunk_ready = std::condition_variable();
+  auto slot_free = std::condition_variable();
+  size_t written = 0;  // The number of chunks passed to write.
+  auto next_chunk = std::atomic<size_t>(0);
+  auto error = std::exception_ptr();
+  bool failed = false;
+
+  auto work = [&] {
+    for (;;) {
+      size_t chunk = next_chunk.fetch_add(1, std::memory_order_relaxed);
+      if (chunk >= num_chunks) return;
+      slot& s = slots[chunk % window];
+      {
+        auto lock = std::unique_lock<std::mutex>(mutex);
+        slot_free.wait(lock,
+                       [&] { return chunk < written + window || failed; });
+        if (failed) return;
+      }
+      FMT_TRY { format_chunk(chunk, s.buf); }
+      FMT_CATCH(...) {
+        auto lock = std::lock_guard<std::mutex>(mutex);
+        if (!failed) error = std::current_exception();
+        failed = true;
+        chunk_ready.notify_all();
+        slot_free.notify_all();
+        return;
+      }
+      auto lock = std::lock_guard<std::mutex>(mutex);
+      s.ready = true;
+      chunk_ready.notify_all();
+    }
+  };
+
+  auto threads = std::vector<std::thread>();
+  for (unsigned i = 0; i < num_threads; ++i) threads.emplace_back(work);
+  FMT_TRY {
+    for (; written < num_chunks;) {
+      slot& s = slots[written % window];
+      {
+        auto lock = std::unique_lock<std::mutex>(mutex);
+        chunk_ready.wait(lock, [&] { return s.ready || failed; });
+        if (failed) break;
+      }
+      // The slot is owned by this thread until it is marked as not ready.
+      write(string_view(s.buf.data(), s.buf.size()));
+      auto lock = std::lock_guard<std::mutex>(mutex);
+      s.ready = false;
+      ++written;
+      slot_free.notify_all();
+    }
+  }
+  FMT_CATCH(...) {
+    auto lock = std::lock_guard<std::mutex>(mutex);
+    if (!failed) error = std::current_exception();
+    failed = true;
+    slot_free.notify_all();
+  }
+  for (auto& t : threads) t.join();
+  if (error) std::rethrow_exception(error);
+}
+
+}  // namespace detail
+
+FMT_BEGIN_EXPORT
+
+/**
+ * Formats each row of `rows` with the format string `fmt` and writes the
+ * results in order to `sink`. The sink can be a `FILE*`, an object with a
+ * `print` member function such as `fmt::ostream` or a function object
+ * accepting `fmt::string_view`. It is only called from the calling thread.
+ *
+ * The format string is parsed once and rows are formatted concurrently on
+ * `num_threads` threads (the number of hardware threads if 0) in chunks of
+ * `chunk_size` rows. Memory use doesn't depend on the number of rows: at
+ * most `2 * num_threads` formatted chunks are kept waiting to be written.
+ *
+ * **Example**:
+ *
+ *     auto rows = std::vector<std::tuple<int, std::string>>{{1, "one"}};
+ *     fmt::format_batch("{}: {}\n", rows.data(), rows.size(), stdout);
+ */
+template <typename... T, typename Sink>
+void format_batch(format_string<const T&...> fmt,
+                  const std::tuple<T...>* rows, size_t num_rows, Sink&& sink,
+                  unsigned num_threads = 0, size_t chunk_size = 1024) {
+  using row_type = std::tuple<T...>;
+  if (num_rows == 0) return;
+  if (num_threads == 0)
+    num_threads = max_of(std::thread::hardware_concurrency(), 1u);
+  if (chunk_size == 0) chunk_size = 1;
+  auto f = detail::batch_format(fmt.get());
+  auto indices = detail::tuple_index_sequence<row_type>();
+
+  // Format the first row on this thread to record the parsing events.
+  auto buf = memory_buffer();
+  f.record(buf, detail::row_args(rows[0], indices));
+  const row_type* rest = rows + 1;
+  size_t num_rest = num_rows - 1;
+  size_t num_chunks = (num_rest + chunk_size - 1) / chunk_size;
+  detail::batch_write(sink, string_view(buf.data(), buf.size()), 0);
+  if (num_threads == 1 || num_chunks <= 1) {
+    // Write each chunk as it is formatted to keep memory use bounded.
+    for (size_t begin = 0; begin < num_rest; begin += chunk_size) {
+      buf.clear();
+      size_t end = begin + min_of(chunk_size, num_rest - begin);
+      for (size_t i = begin; i < end; ++i)
+        f.format(buf, detail::row_args(rest[i], indices));
+      detail::batch_write(sink, string_view(buf.data(), buf.size()), 0);
+    }
+    return;
+  }
+
+  detail::run_batch(
+      num_chunks, num_threads,
+      [&](size_t chunk, memory_buffer& out) {
+        out.clear();
+        size_t begin = chunk * chunk_size;
+        size_t end = begin + min_of(chunk_size, num_rest - begin);
+        for (size_t i = begin; i < end; ++i)
+          f.format(out, detail::row_args(rest[i], indices));
+      },
+      [&](string_view s) { detail::batch_write(sink, s, 0); });
+}
+
+/// Formats the rows of a vector, see `format_batch` above.
+template <typename... T, typename Sink>
+void format_batch(format_string<const T&...> fmt,
+                  const std::vector<std::tuple<T...>>& rows, Sink&& sink,
+                  unsigned num_threads = 0, size_t chunk_size = 1024) {
+  fmt::format_batch(fmt, rows.data(), rows.size(), sink, num_threads,
+                    chunk_size);
+}
+
+FMT_END_EXPORT
+FMT_END_NAMESPACE
+
+#endif  // FMT_BATCH_H_
@@ -2077,26 +2077,26 @@ struct formatter<std::chrono::duration<Rep, Period>, Char> {
     auto precision = specs.precision;
     specs.precision = -1;
     auto begin = fmt_.begin(), end = fmt_.end();
-    // As a possible future optimization, we could avoid extra copying if width
-    // is not specified.
-    auto buf = basic_memory_buffer<Char>();
-    auto out = basic_appender<Char>(buf);
     detail::handle_dynamic_spec(specs.dynamic_width(), specs.width, width_ref_,
                                 ctx);
     detail::handle_dynamic_spec(specs.dynamic_precision(), precision,
                                 precision_ref_, ctx);
-    if (begin == end || *begin == '}') {
-      out = detail::format_duration_value<Char>(out, d.count(), precision);
-      detail::format_duration_unit<Char, Period>(out);
-    } else {
-      auto f =
-          detail::duration_formatter<Char, Rep, Period>(out, d, ctx.locale());
-      f.precision = precision;
-      f.localized = specs_.localized();
-      detail::parse_chrono_format(begin, end, f);
-    }
-    return detail::write(
-        ctx.out(), basic_string_view<Char>(buf.data(), buf.size()), specs);
+    auto loc = ctx.locale();
+    bool localized = specs_.localized();
+    return detail::write_padded_output<Char>(
+        ctx.out(), specs,
+        [&](basic_appender<Char> out) -> basic_appender<Char> {
+          if (begin == end || *begin == '}') {
+            out =
+                detail::format_duration_value<Char>(out, d.count(), precision);
+            return detail::format_duration_unit<Char, Period>(out);
+          }
+          auto f = detail::duration_formatter<Char, Rep, Period>(out, d, loc);
+          f.precision = precision;
+          f.localized = localized;
+          detail::parse_chrono_format(begin, end, f);
+          return out;
+        });
   }
 };
 
@@ -2141,18 +2141,21 @@ template <typename Char> struct formatter<std::tm, Char> {
   auto do_format(const std::tm& tm, FormatContext& ctx,
                  const Duration* subsecs) const -> decltype(ctx.out()) {
     auto specs = specs_;
-    auto buf = basic_memory_buffer<Char>();
-    auto out = basic_appender<Char>(buf);
     detail::handle_dynamic_spec(specs.dynamic_width(), specs.width, width_ref_,
                                 ctx);
 
     auto loc_ref = specs.localized() ? ctx.locale() : locale_ref();
     detail::get_locale loc(static_cast<bool>(loc_ref), loc_ref);
-    auto w = detail::tm_writer<basic_appender<Char>, Char, Duration>(
-        loc, out, tm, subsecs);
-    detail::parse_chrono_format(fmt_.begin(), fmt_.end(), w);
-    return detail::write(
-        ctx.out(), basic_string_view<Char>(buf.data(), buf.size()), specs);
+    // Most conversion specifiers expand to a few characters.
+    return detail::write_padded_output<Char>(
+        ctx.out(), specs,
+        [&](basic_appender<Char> out) -> basic_appender<Char> {
+          auto w = detail::tm_writer<basic_appender<Char>, Char, Duration>(
+              loc, out, tm, subsecs);
+          detail::parse_chrono_format(fmt_.begin(), fmt_.end(), w);
+          return w.out();
+        },
+        fmt_.size() * 2);
   }
 
  public:
@@ -450,6 +450,26 @@ constexpr auto compile(S fmt) {
   }
 }
 #endif  // defined(__cpp_if_constexpr) && defined(__cpp_return_type_deduction)
+
+#if FMT_PROFILE
+// Returns the position of an output iterator used to compute the size of the
+// output of a compiled format call or 0 if it is unknown.
+template <typename T> auto profile_pos(T* p) -> size_t {
+  return reinterpret_cast<uintptr_t>(p) / sizeof(T);
+}
+template <typename OutputIt,
+          FMT_ENABLE_IF(is_back_insert_iterator<OutputIt>::value ||
+                        std::is_same<OutputIt, appender>::value)>
+auto profile_pos(OutputIt it) -> size_t {
+  return get_container(it).size();
+}
+template <typename OutputIt,
+          FMT_ENABLE_IF(!is_back_insert_iterator<OutputIt>::value &&
+                        !std::is_same<OutputIt, appender>::value)>
+auto profile_pos(OutputIt) -> size_t {
+  return 0;
+}
+#endif
 }  // namespace detail
 
 FMT_BEGIN_EXPORT
@@ -497,6 +517,16 @@ FMT_INLINE FMT_CONSTEXPR_STRING auto format(const S&, T&&... args)
         static_cast<basic_string_view<typename S::char_type>>(S()),
         std::forward<T>(args)...);
   } else {
+#  if FMT_PROFILE
+    if constexpr (std::is_same<typename S::char_type, char>::value) {
+      if (!detail::is_constant_evaluated()) {
+        auto sample = detail::profile_begin(string_view(S()));
+        auto result = fmt::format(compiled, std::forward<T>(args)...);
+        detail::profile_end(sample, result.size());
+        return result;
+      }
+    }
+#  endif
     return fmt::format(compiled, std::forward<T>(args)...);
   }
 }
@@ -511,6 +541,17 @@ FMT_CONSTEXPR auto format_to(OutputIt out, const S&, T&&... args) -> OutputIt {
         out, static_cast<basic_string_view<typename S::char_type>>(S()),
         std::forward<T>(args)...);
   } else {
+#  if FMT_PROFILE
+    if constexpr (std::is_same<typename S::char_type, char>::value) {
+      if (!detail::is_constant_evaluated()) {
+        auto sample = detail::profile_begin(string_view(S()));
+        size_t start = detail::profile_pos(out);
+        auto end = fmt::format_to(out, compiled, std::forward<T>(args)...);
+        detail::profile_end(sample, detail::profile_pos(end) - start);
+        return end;
+      }
+    }
+#  endif
     return fmt::format_to(out, compiled, std::forward<T>(args)...);
   }
 }
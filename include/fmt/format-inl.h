@@ -13,6 +13,7 @@
 #  include <cerrno>  // errno
 #  include <climits>
 #  include <cmath>
+#  include <cstdlib>  // std::getenv
 #  include <exception>
 #endif
 
@@ -26,6 +27,33 @@
 #  include <locale>
 #endif
 
+#if FMT_PROFILE && !defined(FMT_MODULE)
+#  include <chrono>
+#endif
+
+#if FMT_CAPTURE && !defined(FMT_MODULE)
+#  include <thread>  // std::this_thread::yield
+#endif
+
+// SSE2 is a part of x86-64. The AVX2 and AVX-512 variants are compiled with
+// the target attribute so that they don't require -mavx2 and are only used
+// if the CPU supports them.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define FMT_USE_SSE2 1
+#else
+#  define FMT_USE_SSE2 0
+#endif
+#if FMT_USE_SSE2 && (FMT_GCC_VERSION >= 900 || FMT_CLANG_VERSION >= 800)
+#  define FMT_USE_AVX 1
+#  define FMT_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define FMT_USE_AVX 0
+#endif
+#if FMT_USE_SSE2 && !defined(FMT_MODULE)
+#  include <immintrin.h>
+#endif
+
 #ifndef FMT_FUNC
 #  define FMT_FUNC
 #endif
@@ -111,6 +139,7 @@ inline void fwrite_all(const void* ptr, size_t count, FILE* stream) {
 
 template <typename Char>
 FMT_FUNC auto thousands_sep_impl(locale_ref loc) -> thousands_sep_result<Char> {
+  FMT_ADD_STAT(locale_lookups, 1);
   auto&& facet = use_facet<numpunct<Char>>(loc.get<locale>());
   auto grouping = facet.grouping();
   auto thousands_sep = grouping.empty() ? Char() : facet.thousands_sep();
@@ -148,6 +177,7 @@ FMT_FUNC void report_error(const char* message) {
 template <typename Locale> typename Locale::id format_facet<Locale>::id;
 
 template <typename Locale> format_facet<Locale>::format_facet(Locale& loc) {
+  FMT_ADD_STAT(locale_lookups, 1);
   auto& np = detail::use_facet<detail::numpunct<char>>(loc);
   grouping_ = np.grouping();
   if (!grouping_.empty()) separator_ = std::string(1, np.thousands_sep());
@@ -1379,6 +1409,521 @@ small_divisor_case_label:
   return ret_value;
 }
 }  // namespace dragonbox
+
+// Arbitrary-precision integers are converted to decimal using 32-bit words
+// in little-endian order so that all intermediate products fit in uint64_t.
+namespace bigint_decimal {
+using words = basic_memory_buffer<uint32_t, 64>;
+
+// Numbers with at most this many words are converted by repeated division
+// by 10^19 which is faster than divide-and-conquer for small sizes.
+enum { basecase_words = 192 };
+// Operands with fewer words are multiplied with the schoolbook algorithm.
+enum { karatsuba_words = 32 };
+// Powers with fewer words are divided by with long division instead of
+// Barrett reduction that needs a precomputed inverse.
+enum { barrett_words = 128 };
+enum { digits_per_word = 9 };
+enum { digits_per_limb = 19 };
+constexpr uint32_t word_divisor = 1000000000;
+
+inline void trim(words& n) {
+  size_t size = n.size();
+  while (size > 0 && n[size - 1] == 0) --size;
+  n.resize(size);
+}
+
+inline void assign(words& n, const uint32_t* data, size_t size) {
+  n.clear();
+  n.append(data, data + size);
+}
+
+inline void shift_right(words& n, size_t num_words) {
+  if (num_words >= n.size()) return n.resize(0);
+  std::copy(n.data() + num_words, n.data() + n.size(), n.data());
+  n.resize(n.size() - num_words);
+}
+
+inline auto compare(const uint32_t* a, size_t a_size, const uint32_t* b,
+                    size_t b_size) -> int {
+  if (a_size != b_size) return a_size < b_size ? -1 : 1;
+  for (size_t i = a_size; i > 0; --i) {
+    if (a[i - 1] != b[i - 1]) return a[i - 1] < b[i - 1] ? -1 : 1;
+  }
+  return 0;
+}
+
+// Adds b to the n-word number r and returns the carry.
+inline auto add_to(uint32_t* r, size_t n, const uint32_t* b, size_t b_size)
+    -> uint32_t {
+  uint64_t carry = 0;
+  size_t i = 0;
+  for (; i < b_size; ++i) {
+    carry += uint64_t(r[i]) + b[i];
+    r[i] = static_cast<uint32_t>(carry);
+    carry >>= 32;
+  }
+  for (; carry != 0 && i < n; ++i) {
+    carry += r[i];
+    r[i] = static_cast<uint32_t>(carry);
+    carry >>= 32;
+  }
+  return static_cast<uint32_t>(carry);
+}
+
+// Subtracts b from the n-word number r and returns the borrow.
+inline auto subtract_from(uint32_t* r, size_t n, const uint32_t* b,
+                          size_t b_size) -> uint32_t {
+  uint64_t borrow = 0;
+  size_t i = 0;
+  for (; i < b_size; ++i) {
+    uint64_t t = uint64_t(r[i]) - b[i] - borrow;
+    r[i] = static_cast<uint32_t>(t);
+    borrow = t >> 63;
+  }
+  for (; borrow != 0 && i < n; ++i) {
+    uint64_t t = uint64_t(r[i]) - borrow;
+    r[i] = static_cast<uint32_t>(t);
+    borrow = t >> 63;
+  }
+  return static_cast<uint32_t>(borrow);
+}
+
+inline void add(words& a, const uint32_t* b, size_t b_size) {
+  size_t size = max_of(a.size(), b_size) + 1;
+  size_t old_size = a.size();
+  a.resize(size);
+  std::fill_n(a.data() + old_size, size - old_size, 0u);
+  add_to(a.data(), size, b, b_size);
+  trim(a);
+}
+
+// Computes a -= b where a >= b.
+inline void subtract(words& a, const uint32_t* b, size_t b_size) {
+  subtract_from(a.data(), a.size(), b, b_size);
+  trim(a);
+}
+
+// Divides hi * 2^64 + lo by 10^19, where hi < 10^19, using a precomputed
+// reciprocal as described in "Improved division by invariant integers" by
+// Niels Moller and Torbjorn Granlund.
+inline auto divmod_limb(uint64_t hi, uint64_t lo, uint64_t& r) -> uint64_t {
+  constexpr uint64_t d = 10000000000000000000ULL;
+  constexpr uint64_t v = 0xd83c94fb6d2ac34a;  // (2^128 - 1) / d - 2^64
+  uint128_fallback p = umul128(hi, v);
+  uint64_t q0 = p.low() + lo;
+  uint64_t q1 = p.high() + hi + 1 + (q0 < lo ? 1 : 0);
+  r = lo - q1 * d;
+  if (r > q0) {
+    --q1;
+    r += d;
+  }
+  if (r >= d) {
+    ++q1;
+    r -= d;
+  }
+  return q1;
+}
+
+// Writes the digits of n to the range ending at end padded with zeros to
+// min_digits and returns the beginning of the output. The digits are produced
+// 19 at a time by repeated division of 64-bit limbs by 10^19.
+FMT_FUNC auto convert_basecase(char* end, const uint32_t* n, size_t size,
+                               size_t min_digits) -> char* {
+  auto limbs = basic_memory_buffer<uint64_t, basecase_words / 2 + 1>();
+  size_t num_limbs = (size + 1) / 2;
+  limbs.resize(num_limbs);
+  for (size_t i = 0; i < num_limbs; ++i) {
+    uint64_t hi = 2 * i + 1 < size ? n[2 * i + 1] : 0;
+    limbs[i] = (hi << 32) | n[2 * i];
+  }
+  char* p = end;
+  while (num_limbs > 0) {
+    uint64_t r = 0;
+    for (size_t i = num_limbs; i > 0; --i)
+      limbs[i - 1] = divmod_limb(r, limbs[i - 1], r);
+    while (num_limbs > 0 && limbs[num_limbs - 1] == 0) --num_limbs;
+    for (int i = 0; i < digits_per_limb / 2; ++i) {
+      p -= 2;
+      write2digits(p, static_cast<size_t>(r % 100));
+      r /= 100;
+    }
+    *--p = static_cast<char>('0' + r);
+  }
+  while (p != end && *p == '0') ++p;
+  while (to_unsigned(end - p) < min_digits) *--p = '0';
+  return p;
+}
+
+// Computes r = a * b where r has a_size + b_size words and doesn't overlap
+// the operands. Uses Karatsuba multiplication for large operands.
+FMT_FUNC void multiply(uint32_t* r, const uint32_t* a, size_t a_size,
+                       const uint32_t* b, size_t b_size) {
+  if (a_size < b_size) {
+    std::swap(a, b);
+    std::swap(a_size, b_size);
+  }
+  size_t size = a_size + b_size;
+  if (b_size < karatsuba_words) {
+    std::fill_n(r, size, 0u);
+    for (size_t i = 0; i < b_size; ++i) {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < a_size; ++j) {
+        uint64_t t = uint64_t(b[i]) * a[j] + r[i + j] + carry;
+        r[i + j] = static_cast<uint32_t>(t);
+        carry = t >> 32;
+      }
+      r[i + a_size] = static_cast<uint32_t>(carry);
+    }
+    return;
+  }
+  if (a_size >= 2 * b_size) {
+    // Multiply b by slices of a of the same size.
+    std::fill_n(r, size, 0u);
+    auto t = words();
+    for (size_t i = 0; i < a_size; i += b_size) {
+      size_t n = min_of(size_t(b_size), a_size - i);
+      t.resize(n + b_size);
+      multiply(t.data(), a + i, n, b, b_size);
+      add_to(r + i, size - i, t.data(), t.size());
+    }
+    return;
+  }
+  // a = a1 * B^h + a0, b = b1 * B^h + b0 where B = 2^32 and
+  // a * b = a1 * b1 * B^2h + ((a0 + a1) * (b0 + b1) - a0 * b0 - a1 * b1) * B^h
+  //       + a0 * b0.
+  size_t h = a_size / 2;
+  multiply(r, a, h, b, h);
+  multiply(r + 2 * h, a + h, a_size - h, b + h, b_size - h);
+  auto sum_a = words(), sum_b = words(), middle = words();
+  sum_a.resize(a_size - h + 1);
+  std::copy(a + h, a + a_size, sum_a.data());
+  sum_a[a_size - h] = 0;
+  add_to(sum_a.data(), sum_a.size(), a, h);
+  sum_b.resize(max_of(h, b_size - h) + 1);
+  std::fill_n(sum_b.data(), sum_b.size(), 0u);
+  std::copy(b, b + h, sum_b.data());
+  add_to(sum_b.data(), sum_b.size(), b + h, b_size - h);
+  middle.resize(sum_a.size() + sum_b.size());
+  multiply(middle.data(), sum_a.data(), sum_a.size(), sum_b.data(),
+           sum_b.size());
+  subtract_from(middle.data(), middle.size(), r, 2 * h);
+  subtract_from(middle.data(), middle.size(), r + 2 * h, size - 2 * h);
+  trim(middle);
+  add_to(r + h, size - h, middle.data(), middle.size());
+}
+
+inline void multiply(words& result, const uint32_t* a, size_t a_size,
+                     const uint32_t* b, size_t b_size) {
+  result.resize(a_size + b_size);
+  multiply(result.data(), a, a_size, b, b_size);
+  trim(result);
+}
+
+// Computes q = u / v and r = u % v where v has at least two words and the
+// most significant words of u and v are nonzero. This is Knuth's algorithm D
+// from TAOCP vol. 2, section 4.3.1.
+FMT_FUNC void divmod(words& q, words& r, const uint32_t* u, size_t m,
+                     const uint32_t* v, size_t n) {
+  q.resize(0);
+  if (m < n) {
+    r.resize(m);
+    std::copy(u, u + m, r.data());
+    return;
+  }
+  // Normalize so that the most significant bit of the divisor is set.
+  int shift = countl_zero(v[n - 1]);
+  auto vn = words();
+  vn.resize(n);
+  for (size_t i = n - 1; i > 0; --i) {
+    vn[i] = (v[i] << shift) |
+            static_cast<uint32_t>(uint64_t(v[i - 1]) >> (32 - shift));
+  }
+  vn[0] = v[0] << shift;
+  auto un = words();
+  un.resize(m + 1);
+  un[m] = static_cast<uint32_t>(uint64_t(u[m - 1]) >> (32 - shift));
+  for (size_t i = m - 1; i > 0; --i) {
+    un[i] = (u[i] << shift) |
+            static_cast<uint32_t>(uint64_t(u[i - 1]) >> (32 - shift));
+  }
+  un[0] = u[0] << shift;
+
+  const uint64_t base = uint64_t(1) << 32;
+  q.resize(m - n + 1);
+  for (size_t j = m - n + 1; j-- > 0;) {
+    uint64_t num = (uint64_t(un[j + n]) << 32) | un[j + n - 1];
+    uint64_t qhat = num / vn[n - 1];
+    uint64_t rhat = num % vn[n - 1];
+    while (qhat >= base ||
+           qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+      --qhat;
+      rhat += vn[n - 1];
+      if (rhat >= base) break;
+    }
+    // Multiply and subtract.
+    int64_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t p = qhat * vn[i];
+      int64_t t = int64_t(un[i + j]) - borrow - int64_t(p & 0xffffffff);
+      un[i + j] = static_cast<uint32_t>(t);
+      borrow = int64_t(p >> 32) - (t >> 32);
+    }
+    int64_t t = int64_t(un[j + n]) - borrow;
+    un[j + n] = static_cast<uint32_t>(t);
+    q[j] = static_cast<uint32_t>(qhat);
+    if (t < 0) {
+      // The estimate was one too large, add the divisor back.
+      --q[j];
+      uint64_t carry = 0;
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t s = uint64_t(un[i + j]) + vn[i] + carry;
+        un[i + j] = static_cast<uint32_t>(s);
+        carry = s >> 32;
+      }
+      un[j + n] += static_cast<uint32_t>(carry);
+    }
+  }
+  trim(q);
+  // Unnormalize the remainder.
+  r.resize(n);
+  for (size_t i = 0; i < n - 1; ++i) {
+    r[i] = (un[i] >> shift) |
+           static_cast<uint32_t>((uint64_t(un[i + 1]) << (32 - shift)));
+  }
+  r[n - 1] = un[n - 1] >> shift;
+  trim(r);
+}
+
+// Computes result = floor(B^(2n) / v) where B = 2^32 and v has n words.
+// The inverse of the upper half of v is refined with one Newton iteration.
+FMT_FUNC void invert(words& result, const uint32_t* v, size_t n) {
+  auto num = words();
+  num.resize(2 * n + 1);
+  std::fill_n(num.data(), num.size(), 0u);
+  num[2 * n] = 1;
+  auto t = words();
+  if (n < 2 * karatsuba_words) return divmod(result, t, num.data(),
+                                             num.size(), v, n);
+  // Two extra words make the error of the iteration a few units at most.
+  size_t h = n / 2 + 2;
+  auto x = words(), square = words();
+  invert(x, v + (n - h), h);
+  // result = 2 * x * B^(n - h) - floor(v * x^2 / B^(2h))
+  multiply(square, x.data(), x.size(), x.data(), x.size());
+  multiply(t, v, n, square.data(), square.size());
+  shift_right(t, 2 * h);
+  result.resize(n - h);
+  std::fill_n(result.data(), result.size(), 0u);
+  result.append(x.data(), x.data() + x.size());
+  assign(x, result.data(), result.size());
+  add(result, x.data(), x.size());
+  subtract(result, t.data(), t.size());
+
+  // Correct the result so that v * result <= B^(2n) < v * (result + 1).
+  const uint32_t one = 1;
+  multiply(t, v, n, result.data(), result.size());
+  while (compare(t.data(), t.size(), num.data(), num.size()) > 0) {
+    subtract(result, &one, 1);
+    subtract(t, v, n);
+  }
+  for (;;) {
+    add(t, v, n);
+    if (compare(t.data(), t.size(), num.data(), num.size()) > 0) break;
+    add(result, &one, 1);
+  }
+}
+
+// Converts numbers by splitting them with powers[k] = 10^(9 * 2^k) into
+// halves that are converted recursively. Large powers are divided by with
+// Barrett reduction using precomputed inverses so that the conversion takes
+// O(M(n) log n) time where M(n) is the time of Karatsuba multiplication.
+class converter {
+ private:
+  words powers_;
+  words inverses_;
+  size_t offsets_[64];  // Offsets of powers in powers_.
+  size_t sizes_[64];
+  size_t inverse_offsets_[64];
+  size_t inverse_sizes_[64];
+  int num_powers_ = 0;
+
+  auto power(int k) const -> const uint32_t* {
+    return powers_.data() + offsets_[k];
+  }
+
+  void add_power(const uint32_t* data, size_t size) {
+    int k = num_powers_++;
+    offsets_[k] = powers_.size();
+    sizes_[k] = size;
+    powers_.append(data, data + size);
+    inverse_offsets_[k] = inverses_.size();
+    inverse_sizes_[k] = 0;
+    if (size < barrett_words) return;
+    auto inverse = words();
+    invert(inverse, power(k), size);
+    inverse_sizes_[k] = inverse.size();
+    inverses_.append(inverse.data(), inverse.data() + inverse.size());
+  }
+
+  // Computes q = u / powers[k] and r = u % powers[k].
+  void divmod(words& q, words& r, const words& u, int k) const {
+    const uint32_t* v = power(k);
+    size_t n = sizes_[k];
+    if (inverse_sizes_[k] == 0)
+      return bigint_decimal::divmod(q, r, u.data(), u.size(), v, n);
+    if (u.size() > 2 * n) {
+      // Divide the upper words first as in long division.
+      auto upper = words(), lower = words(), upper_q = words();
+      assign(upper, u.data() + n, u.size() - n);
+      divmod(upper_q, r, upper, k);
+      assign(lower, u.data(), n);
+      lower.append(r.data(), r.data() + r.size());
+      trim(lower);
+      divmod(q, r, lower, k);
+      size_t size = q.size();
+      q.resize(n);
+      std::fill_n(q.data() + size, n - size, 0u);
+      q.append(upper_q.data(), upper_q.data() + upper_q.size());
+      trim(q);
+      return;
+    }
+    // Barrett reduction: the quotient estimate is at most 2 less than q.
+    const uint32_t* inverse = inverses_.data() + inverse_offsets_[k];
+    auto t = words();
+    assign(t, u.data(), u.size());
+    shift_right(t, n - 1);
+    multiply(q, t.data(), t.size(), inverse, inverse_sizes_[k]);
+    shift_right(q, n + 1);
+    multiply(t, q.data(), q.size(), v, n);
+    assign(r, u.data(), u.size());
+    subtract(r, t.data(), t.size());
+    const uint32_t one = 1;
+    while (compare(r.data(), r.size(), v, n) >= 0) {
+      subtract(r, v, n);
+      add(q, &one, 1);
+    }
+  }
+
+ public:
+  explicit converter(size_t size) {
+    add_power(&word_divisor, 1);
+    auto square = words();
+    while (sizes_[num_powers_ - 1] * 4 <= size && num_powers_ < 64) {
+      int k = num_powers_ - 1;
+      multiply(square, power(k), sizes_[k], power(k), sizes_[k]);
+      add_power(square.data(), square.size());
+    }
+  }
+
+  auto num_powers() const -> int { return num_powers_; }
+
+  auto convert(char* end, words& n, int k, size_t min_digits) const -> char* {
+    // Split by the largest power with at most half the size of n.
+    while (k > 0 && sizes_[k] * 2 > n.size()) --k;
+    if (n.size() <= basecase_words || k == 0)
+      return convert_basecase(end, n.data(), n.size(), min_digits);
+    auto q = words(), r = words();
+    divmod(q, r, n, k);
+    size_t low_digits = size_t(digits_per_word) << k;
+    if (q.size() == 0) return convert(end, r, k - 1, min_digits);
+    convert(end, r, k - 1, low_digits);
+    return convert(end - low_digits, q, k,
+                   min_digits > low_digits ? min_digits - low_digits : 0);
+  }
+};
+}  // namespace bigint_decimal
+
+FMT_FUNC void format_bigint_decimal(memory_buffer& out, const uint64_t* limbs,
+                                    size_t size) {
+  auto n = bigint_decimal::words();
+  n.resize(size * 2);
+  for (size_t i = 0; i < size; ++i) {
+    n[2 * i] = static_cast<uint32_t>(limbs[i]);
+    n[2 * i + 1] = static_cast<uint32_t>(limbs[i] >> 32);
+  }
+  bigint_decimal::trim(n);
+  if (n.size() == 0) {
+    out.push_back('0');
+    return;
+  }
+  // 32 * log10(2) < 9.64 digits per word. Conversion of the most significant
+  // limb can write up to 18 leading zeros that are removed.
+  size_t max_digits = n.size() * 964 / 100 + bigint_decimal::digits_per_limb;
+  size_t start = out.size();
+  out.resize(start + max_digits);
+  char* end = out.data() + out.size();
+  bigint_decimal::converter conv(n.size());
+  char* begin = conv.convert(end, n, conv.num_powers() - 1, 0);
+  size_t num_digits = to_unsigned(end - begin);
+  std::copy(begin, end, out.data() + start);
+  out.resize(start + num_digits);
+}
+
+// Writes 8 hex digits of value to out by spreading its nibbles to the bytes
+// of a 64-bit integer in memory order and converting them all at once.
+inline void write_hex8(char* out, uint32_t value, bool upper) {
+  uint64_t v = value;
+  if (is_big_endian()) {
+    v = ((v & 0xffff0000) << 16) | (v & 0xffff);
+    v = ((v & 0x0000ff000000ff00) << 8) | (v & 0x000000ff000000ff);
+    v = ((v & 0x00f000f000f000f0) << 4) | (v & 0x000f000f000f000f);
+  } else {
+    v = ((v & 0xffff) << 32) | (v >> 16);
+    v = ((v & 0x000000ff000000ff) << 16) | ((v >> 8) & 0x000000ff000000ff);
+    v = ((v & 0x000f000f000f000f) << 8) | ((v >> 4) & 0x000f000f000f000f);
+  }
+  uint64_t letters = ((v + 0x0606060606060606) >> 4) & 0x0101010101010101;
+  v += 0x3030303030303030 + letters * (upper ? 7 : 39);
+  std::memcpy(out, &v, sizeof(v));
+}
+
+FMT_FUNC void format_bigint_base2e(memory_buffer& out, const uint64_t* limbs,
+                                   size_t size, int bits, bool upper) {
+  while (size > 0 && limbs[size - 1] == 0) --size;
+  if (size == 0) {
+    out.push_back('0');
+    return;
+  }
+  const char* xdigits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  unsigned mask = (1u << bits) - 1;
+  size_t num_bits = size * 64 - to_unsigned(countl_zero(limbs[size - 1]));
+  size_t num_digits = (num_bits + to_unsigned(bits) - 1) / to_unsigned(bits);
+  size_t start = out.size();
+  out.resize(start + num_digits);
+  char* p = out.data() + start + num_digits;
+  if (bits == 4) {
+    // All limbs except the most significant one have exactly 16 digits.
+    for (size_t i = 0; i + 1 < size; ++i) {
+      p -= 16;
+      write_hex8(p, static_cast<uint32_t>(limbs[i] >> 32), upper);
+      write_hex8(p + 8, static_cast<uint32_t>(limbs[i]), upper);
+    }
+    for (uint64_t limb = limbs[size - 1]; p != out.data() + start; limb >>= 4)
+      *--p = xdigits[limb & 0xf];
+    return;
+  }
+  if (64 % bits == 0) {
+    // Digits don't cross limb boundaries.
+    int digits_per_limb = 64 / bits;
+    for (size_t i = 0; i < size; ++i) {
+      uint64_t limb = limbs[i];
+      for (int j = 0; j < digits_per_limb && p != out.data() + start; ++j) {
+        *--p = xdigits[limb & mask];
+        limb >>= bits;
+      }
+    }
+    return;
+  }
+  for (size_t pos = 0; p != out.data() + start; pos += to_unsigned(bits)) {
+    size_t i = pos / 64;
+    int offset = static_cast<int>(pos % 64);
+    uint64_t value = limbs[i] >> offset;
+    if (offset + bits > 64 && i + 1 < size)
+      value |= limbs[i + 1] << (64 - offset);
+    *--p = xdigits[value & mask];
+  }
+}
 }  // namespace detail
 
 template <> struct formatter<detail::bigint> {
@@ -1443,18 +1988,751 @@ FMT_FUNC auto vformat(string_view fmt, format_args args) -> std::string {
   // can be better optimized in fmt::format anyway.
   auto buffer = memory_buffer();
   detail::vformat_to(buffer, fmt, args);
+  FMT_ADD_STAT(format_calls, 1);
+  FMT_ADD_STAT(allocations,
+               buffer.size() > std::string().capacity() ? 1 : 0);
   return to_string(buffer);
 }
 
 namespace detail {
+#if FMT_STATS
+struct stats_registry {
+  std::atomic<stats_block*> head{nullptr};
+  // Counters updated by exiting threads after they released their blocks.
+  stats_block retired = {};
+};
 
-FMT_FUNC void vformat_to(buffer<char>& buf, string_view fmt, format_args args,
-                         locale_ref loc) {
+inline auto get_stats_registry() -> stats_registry& {
+  // Intentionally leaked to be usable from thread exit handlers.
+  static auto* registry = new stats_registry();
+  return *registry;
+}
+
+inline auto acquire_stats_block() -> stats_block* {
+  auto& registry = get_stats_registry();
+  for (auto* b = registry.head.load(std::memory_order_acquire); b;
+       b = b->next) {
+    bool in_use = false;
+    if (b->in_use.compare_exchange_strong(in_use, true,
+                                          std::memory_order_acquire)) {
+      return b;
+    }
+  }
+  auto* b = new stats_block();
+  b->in_use.store(true, std::memory_order_relaxed);
+  b->next = registry.head.load(std::memory_order_relaxed);
+  while (!registry.head.compare_exchange_weak(b->next, b,
+                                              std::memory_order_release)) {
+  }
+  return b;
+}
+
+struct thread_stats_state {
+  stats_block* block;
+  // Counts of the previous owners of the block. Blocks are never reset, so
+  // that a thread exit doesn't decrease the totals returned by fmt::stats.
+  unsigned long long base[static_cast<int>(stat::num_stats)];
+};
+
+// Acquires a block for the current thread and releases it on thread exit.
+struct stats_owner {
+  thread_stats_state& state;
+
+  explicit stats_owner(thread_stats_state& s) : state(s) {
+    state.block = acquire_stats_block();
+    for (int i = 0; i < static_cast<int>(stat::num_stats); ++i)
+      state.base[i] = state.block->values[i].load(std::memory_order_relaxed);
+  }
+
+  ~stats_owner() {
+    state.block->in_use.store(false, std::memory_order_release);
+    // The block may be reused by another thread while destructors of other
+    // thread_local objects of this thread still update the counters. The
+    // state is stored outside of the owner because a store to a member in
+    // a destructor can be eliminated as dead.
+    state.block = nullptr;
+  }
+};
+
+inline auto get_thread_stats_state() -> thread_stats_state& {
+  static thread_local thread_stats_state state = {};
+  static thread_local stats_owner owner(state);
+  return state;
+}
+
+FMT_FUNC auto local_stats() -> stats_block* {
+  return get_thread_stats_state().block;
+}
+
+FMT_FUNC auto retired_stats() -> stats_block& {
+  return get_stats_registry().retired;
+}
+
+inline void add_stats(format_stats& s, const stats_block& b,
+                      const unsigned long long* base = nullptr) {
+  auto get = [&](stat id) {
+    int i = static_cast<int>(id);
+    return b.values[i].load(std::memory_order_relaxed) - (base ? base[i] : 0);
+  };
+  s.format_calls += get(stat::format_calls);
+  s.allocations += get(stat::allocations);
+  s.buffer_grows += get(stat::buffer_grows);
+  s.buffer_grow_bytes += get(stat::buffer_grow_bytes);
+  s.float_fast_path += get(stat::float_fast_path);
+  s.float_dragon_fallbacks += get(stat::float_dragon_fallbacks);
+  s.locale_lookups += get(stat::locale_lookups);
+  s.file_locks += get(stat::file_locks);
+  s.ostream_flushes += get(stat::ostream_flushes);
+}
+#endif  // FMT_STATS
+
+#if FMT_PROFILE
+#  ifndef FMT_PROFILE_SAMPLE_RATE
+#    define FMT_PROFILE_SAMPLE_RATE 16
+#  endif
+
+// Returns the current time in CPU cycles if available or in nanoseconds.
+inline auto profile_ticks() -> unsigned long long {
+#  if FMT_MSC_VERSION && (defined(_M_X64) || defined(_M_IX86))
+  return __rdtsc();
+#  elif (FMT_GCC_VERSION || FMT_CLANG_VERSION) && \
+      (defined(__x86_64__) || defined(__i386__))
+  return __builtin_ia32_rdtsc();
+#  else
+  using namespace std::chrono;
+  auto t = steady_clock::now().time_since_epoch();
+  return static_cast<unsigned long long>(duration_cast<nanoseconds>(t).count());
+#  endif
+}
+
+inline auto profile_tick_unit() -> const char* {
+#  if (FMT_MSC_VERSION && (defined(_M_X64) || defined(_M_IX86))) || \
+      ((FMT_GCC_VERSION || FMT_CLANG_VERSION) &&                 \
+       (defined(__x86_64__) || defined(__i386__)))
+  return "cycles";
+#  else
+  return "ns";
+#  endif
+}
+
+// Statistics of a call site. Only the owning thread writes to an entry. The
+// key is published last so that readers that see it also see the text.
+struct profile_entry {
+  std::atomic<const void*> key;
+  std::atomic<unsigned long long> calls;
+  std::atomic<unsigned long long> size;
+  std::atomic<unsigned long long> sampled_calls;
+  std::atomic<unsigned long long> sampled_ticks;
+  char text[48];  // A prefix of the format string.
+  bool truncated;
+};
+
+// A per-thread open addressing hash table of call sites.
+struct profile_table {
+  enum { num_entries = 1024 };
+  profile_entry entries[num_entries];
+  std::atomic<unsigned long long> dropped;  // Calls that didn't fit.
+  std::atomic<bool> in_use;
+  profile_table* next;
+};
+
+struct profile_registry {
+  std::atomic<profile_table*> head{nullptr};
+};
+
+inline auto get_profile_registry() -> profile_registry& {
+  // Intentionally leaked to be usable from thread exit handlers.
+  static auto* registry = new profile_registry();
+  return *registry;
+}
+
+// Tables of exited threads keep their entries and are reused by new
+// threads, so the profile covers all threads.
+struct profile_owner {
+  profile_table* table;
+
+  ~profile_owner() { table->in_use.store(false, std::memory_order_release); }
+};
+
+inline auto acquire_profile_table() -> profile_table* {
+  auto& registry = get_profile_registry();
+  for (auto* t = registry.head.load(std::memory_order_acquire); t;
+       t = t->next) {
+    bool in_use = false;
+    if (t->in_use.compare_exchange_strong(in_use, true,
+                                          std::memory_order_acquire)) {
+      return t;
+    }
+  }
+  auto* t = new profile_table();
+  t->in_use.store(true, std::memory_order_relaxed);
+  t->next = registry.head.load(std::memory_order_relaxed);
+  while (!registry.head.compare_exchange_weak(t->next, t,
+                                              std::memory_order_release)) {
+  }
+  return t;
+}
+
+inline auto local_profile_table() -> profile_table& {
+  static thread_local profile_owner owner{acquire_profile_table()};
+  return *owner.table;
+}
+
+inline void add_relaxed(std::atomic<unsigned long long>& value,
+                        unsigned long long n) {
+  value.store(value.load(std::memory_order_relaxed) + n,
+              std::memory_order_relaxed);
+}
+
+FMT_FUNC auto profile_begin(string_view fmt) -> profile_sample {
+  auto& table = local_profile_table();
+  const void* key = fmt.data();
+  auto hash = reinterpret_cast<uintptr_t>(key) * 0x9e3779b97f4a7c15ull;
+  size_t mask = profile_table::num_entries - 1;
+  size_t index = static_cast<size_t>(hash >> 32) & mask;
+  for (size_t i = 0; i < profile_table::num_entries; ++i) {
+    auto& entry = table.entries[(index + i) & mask];
+    const void* entry_key = entry.key.load(std::memory_order_relaxed);
+    if (!entry_key) {
+      size_t n = min_of(fmt.size(), sizeof(entry.text) - 1);
+      memcpy(entry.text, fmt.data(), n);
+      entry.text[n] = '\0';
+      entry.truncated = n < fmt.size();
+      entry.key.store(key, std::memory_order_release);
+    } else if (entry_key != key) {
+      continue;
+    }
+    bool sampled =
+        entry.calls.load(std::memory_order_relaxed) % FMT_PROFILE_SAMPLE_RATE ==
+        0;
+    return {&entry, sampled ? profile_ticks() : 0};
+  }
+  add_relaxed(table.dropped, 1);
+  return {nullptr, 0};
+}
+
+FMT_FUNC void profile_end(profile_sample sample, size_t size) {
+  profile_entry* entry = sample.entry;
+  if (!entry) return;
+  if (sample.start != 0) {
+    add_relaxed(entry->sampled_calls, 1);
+    add_relaxed(entry->sampled_ticks, profile_ticks() - sample.start);
+  }
+  add_relaxed(entry->calls, 1);
+  add_relaxed(entry->size, size);
+}
+
+struct profile_site {
+  const void* key;
+  const char* text;
+  bool truncated;
+  unsigned long long calls;
+  unsigned long long size;
+  unsigned long long sampled_calls;
+  unsigned long long sampled_ticks;
+
+  // Returns the total cost estimated from the sampled calls.
+  auto cost() const -> double {
+    if (sampled_calls == 0) return 0;
+    return static_cast<double>(sampled_ticks) /
+           static_cast<double>(sampled_calls) * static_cast<double>(calls);
+  }
+};
+#endif  // FMT_PROFILE
+
+#if FMT_CAPTURE
+struct capture_state {
+  std::atomic<FILE*> file{nullptr};
+  std::atomic<int> writers{0};  // The number of threads writing to file.
+  std::atomic<unsigned long long> calls{0};
+  std::atomic<unsigned long long> records{0};
+  std::atomic<unsigned> sample_rate{1};
+  std::atomic<unsigned long long> max_records{0};
+};
+
+inline auto get_capture_state() -> capture_state& {
+  // Intentionally leaked to be usable from static destructors.
+  static auto* state = new capture_state();
+  return *state;
+}
+
+// Writes argument values as text.
+struct capture_writer {
+  buffer<char>& buf;
+  format_args args;
+
+  template <typename T, FMT_ENABLE_IF(is_integral<T>::value ||
+                                      is_floating_point<T>::value)>
+  void operator()(T value) {
+    detail::write<char>(appender(buf), value);
+  }
+  void operator()(const char* s) {
+    if (s) (*this)(string_view(s));
+  }
+  void operator()(string_view s) { buf.append(s.begin(), s.end()); }
+  void operator()(const void* p) { detail::write<char>(appender(buf), p); }
+  void operator()(basic_format_arg<context>::handle h) {
+    // User-defined types are stringified with an empty format spec.
+    auto parse_ctx = parse_context<char>({});
+    auto ctx = context(appender(buf), args);
+    FMT_TRY { h.format(parse_ctx, ctx); }
+    FMT_CATCH(...) {}
+  }
+  template <typename T, FMT_ENABLE_IF(!is_integral<T>::value &&
+                                      !is_floating_point<T>::value)>
+  void operator()(T) {}
+};
+
+// Writes `text` prefixed with its size.
+inline void write_capture_string(buffer<char>& buf, string_view text) {
+  detail::write<char>(appender(buf), text.size());
+  buf.push_back(':');
+  buf.append(text.begin(), text.end());
+  buf.push_back('\n');
+}
+
+// Finds the names of named arguments referenced in `fmt` and stores them at
+// the argument indices in `names`.
+inline void find_capture_names(string_view fmt, format_args args,
+                               basic_memory_buffer<string_view>& names) {
+  const char* end = fmt.end();
+  for (const char* p = fmt.begin(); p != end; ++p) {
+    if (*p != '{') continue;
+    if (++p == end) break;
+    if (*p == '{' || !is_name_start(*p)) continue;
+    const char* name_begin = p;
+    do {
+      ++p;
+    } while (p != end && (is_name_start(*p) || ('0' <= *p && *p <= '9')));
+    auto name = string_view(name_begin, to_unsigned(p - name_begin));
+    int id = args.get_id(name);
+    if (id >= 0 && to_unsigned(id) < names.size())
+      names[to_unsigned(id)] = name;
+    if (p == end) break;
+  }
+}
+
+// Records a formatting call in the trace. The record format is
+//   <num_args> <size>:<format string>\n
+// followed by a line for each argument
+//   <type> <size>:<value>\n
+// where <type> is a character from "iulmnobcfdezspx" corresponding to the
+// argument type. The line of a named argument is preceded by
+//   = <size>:<name>\n
+inline void capture_call(string_view fmt, format_args args) {
+  auto& state = get_capture_state();
+  if (!state.file.load(std::memory_order_relaxed)) return;
+  if (state.calls.fetch_add(1, std::memory_order_relaxed) %
+              state.sample_rate.load(std::memory_order_relaxed) !=
+          0 ||
+      state.records.load(std::memory_order_relaxed) >=
+          state.max_records.load(std::memory_order_relaxed)) {
+    return;
+  }
+  int num_args = 0;
+  while (args.get(num_args)) ++num_args;
+  auto buf = memory_buffer();
+  detail::write<char>(appender(buf), num_args);
+  buf.push_back(' ');
+  write_capture_string(buf, fmt);
+  auto names = basic_memory_buffer<string_view>();
+  names.resize(to_unsigned(num_args));
+  find_capture_names(fmt, args, names);
+  auto value = memory_buffer();
+  for (int i = 0; i < num_args; ++i) {
+    string_view name = names[to_unsigned(i)];
+    if (name.size() != 0) {
+      buf.append(string_view("= "));
+      write_capture_string(buf, name);
+    }
+    auto arg = args.get(i);
+    buf.push_back("-iulmnobcfdezspx"[static_cast<int>(arg.type())]);
+    buf.push_back(' ');
+    value.clear();
+    arg.visit(capture_writer{value, args});
+    write_capture_string(buf, {value.data(), value.size()});
+  }
+
+  // The increment of writers and the load of file pair with the exchange of
+  // file and the load of writers in stop_capture. Sequential consistency
+  // guarantees that at least one side sees the other's store, so the file
+  // is not closed while being written.
+  state.writers.fetch_add(1, std::memory_order_seq_cst);
+  FILE* f = state.file.load(std::memory_order_seq_cst);
+  if (f && state.records.fetch_add(1, std::memory_order_relaxed) <
+               state.max_records.load(std::memory_order_relaxed)) {
+    // A single fwrite keeps records from different threads separate.
+    std::fwrite(buf.data(), 1, buf.size(), f);
+  }
+  state.writers.fetch_sub(1, std::memory_order_release);
+}
+
+// Captures a top-level formatting call. Calls made while formatting
+// user-defined types are part of the outer call and are not recorded.
+class capture_scope {
+ private:
+  static auto depth() -> int& {
+    static thread_local int value = 0;
+    return value;
+  }
+
+ public:
+  capture_scope(string_view fmt, format_args args) {
+    if (depth()++ == 0) capture_call(fmt, args);
+  }
+  ~capture_scope() { --depth(); }
+  capture_scope(const capture_scope&) = delete;
+  void operator=(const capture_scope&) = delete;
+};
+#endif  // FMT_CAPTURE
+}  // namespace detail
+
+FMT_FUNC void dump_profile(std::FILE* f) {
+#if FMT_PROFILE
+  using detail::profile_site;
+  auto sites = basic_memory_buffer<profile_site, 64>();
+  unsigned long long dropped = 0;
+  auto& registry = detail::get_profile_registry();
+  for (auto* t = registry.head.load(std::memory_order_acquire); t;
+       t = t->next) {
+    dropped += t->dropped.load(std::memory_order_relaxed);
+    for (auto& e : t->entries) {
+      const void* key = e.key.load(std::memory_order_acquire);
+      if (!key) continue;
+      sites.push_back({key, e.text, e.truncated,
+                       e.calls.load(std::memory_order_relaxed),
+                       e.size.load(std::memory_order_relaxed),
+                       e.sampled_calls.load(std::memory_order_relaxed),
+                       e.sampled_ticks.load(std::memory_order_relaxed)});
+    }
+  }
+
+  // Merge the entries of the same call site from different threads.
+  std::sort(sites.begin(), sites.end(),
+            [](const profile_site& a, const profile_site& b) {
+              return reinterpret_cast<uintptr_t>(a.key) <
+                     reinterpret_cast<uintptr_t>(b.key);
+            });
+  size_t num_sites = 0;
+  for (const auto& site : sites) {
+    if (num_sites != 0 && sites[num_sites - 1].key == site.key) {
+      auto& merged = sites[num_sites - 1];
+      merged.calls += site.calls;
+      merged.size += site.size;
+      merged.sampled_calls += site.sampled_calls;
+      merged.sampled_ticks += site.sampled_ticks;
+    } else {
+      sites[num_sites++] = site;
+    }
+  }
+  sites.resize(num_sites);
+  std::sort(sites.begin(), sites.end(),
+            [](const profile_site& a, const profile_site& b) {
+              return a.cost() > b.cost();
+            });
+
+  double total_cost = 0;
+  for (const auto& site : sites) total_cost += site.cost();
+  fmt::print(f, "{:>7} {:>12} {:>14} {:>12}  {}\n", "cost", "calls", "bytes",
+             fmt::format("{}/call", detail::profile_tick_unit()),
+             "format string");
+  for (const auto& site : sites) {
+    double per_call = site.sampled_calls != 0
+                          ? static_cast<double>(site.sampled_ticks) /
+                                static_cast<double>(site.sampled_calls)
+                          : 0;
+    double share = total_cost > 0 ? site.cost() / total_cost * 100 : 0;
+    fmt::print(f, "{:>6.2f}% {:>12} {:>14} {:>12.0f}  {:?}{}\n", share,
+               site.calls, site.size, per_call, string_view(site.text),
+               site.truncated ? "..." : "");
+  }
+  if (dropped != 0) {
+    fmt::print(f, "{} calls from sites that didn't fit in the table\n",
+               dropped);
+  }
+#else
+  fmt::print(f, "profiling is disabled, compile with FMT_PROFILE=1\n");
+#endif
+}
+
+FMT_FUNC void start_capture(const char* path, unsigned sample_rate,
+                            unsigned long long max_records) {
+#if FMT_CAPTURE
+  stop_capture();
+  FILE* f = std::fopen(path, "wb");
+  if (!f) FMT_THROW(system_error(errno, FMT_STRING("cannot open {}"), path));
+  std::fputs("fmt-capture 2\n", f);
+  auto& state = detail::get_capture_state();
+  state.calls.store(0, std::memory_order_relaxed);
+  state.records.store(0, std::memory_order_relaxed);
+  state.sample_rate.store(sample_rate != 0 ? sample_rate : 1,
+                          std::memory_order_relaxed);
+  state.max_records.store(max_records, std::memory_order_relaxed);
+  state.file.store(f, std::memory_order_release);
+#else
+  detail::ignore_unused(path, sample_rate, max_records);
+  report_error("capture is disabled, compile with FMT_CAPTURE=1");
+#endif
+}
+
+FMT_FUNC void stop_capture() {
+#if FMT_CAPTURE
+  auto& state = detail::get_capture_state();
+  FILE* f = state.file.exchange(nullptr, std::memory_order_seq_cst);
+  if (!f) return;
+  // Wait for the threads that are writing records.
+  while (state.writers.load(std::memory_order_seq_cst) != 0)
+    std::this_thread::yield();
+  std::fclose(f);
+#endif
+}
+
+FMT_FUNC auto stats() -> format_stats {
+  auto result = format_stats();
+#if FMT_STATS
+  // Blocks are never reset and the retired block only receives counts after
+  // the owner has released its block, so the result is monotonic.
+  auto& registry = detail::get_stats_registry();
+  for (auto* b = registry.head.load(std::memory_order_acquire); b;
+       b = b->next) {
+    detail::add_stats(result, *b);
+  }
+  detail::add_stats(result, registry.retired);
+#endif
+  return result;
+}
+
+FMT_FUNC auto thread_stats() -> format_stats {
+  auto result = format_stats();
+#if FMT_STATS
+  auto& state = detail::get_thread_stats_state();
+  if (state.block) detail::add_stats(result, *state.block, state.base);
+#endif
+  return result;
+}
+
+namespace detail {
+
+inline auto first_set_bit(unsigned long long mask) -> int {
+#if FMT_GCC_VERSION || FMT_CLANG_VERSION
+  return __builtin_ctzll(mask);
+#else
+  int n = 0;
+  for (; (mask & 1) == 0; mask >>= 1) ++n;
+  return n;
+#endif
+}
+
+// Kernels provide a scalar predicate and its vector versions that return
+// a mask of matching chars.
+struct escape_kernel {
+  static auto match(unsigned char c) -> bool {
+    return c < 0x20 || c == '"' || c == '\\' || c >= 0x7f;
+  }
+#if FMT_USE_SSE2
+  static auto match(__m128i v) -> __m128i {
+    // Non-ASCII chars are negative and compare less than 0x20.
+    auto m = _mm_cmplt_epi8(v, _mm_set1_epi8(0x20));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+    return _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f)));
+  }
+#endif
+#if FMT_USE_AVX
+  FMT_TARGET("avx2") static auto match(__m256i v) -> __m256i {
+    auto m = _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v);
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+    return _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f)));
+  }
+  FMT_TARGET("avx512f,avx512bw") static auto match(__m512i v) -> __mmask64 {
+    return _mm512_cmplt_epi8_mask(v, _mm512_set1_epi8(0x20)) |
+           _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"')) |
+           _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\')) |
+           _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(0x7f));
+  }
+#endif
+};
+
+struct non_ascii_kernel {
+  static auto match(unsigned char c) -> bool { return c >= 0x80; }
+#if FMT_USE_SSE2
+  static auto match(__m128i v) -> __m128i { return v; }
+#endif
+#if FMT_USE_AVX
+  FMT_TARGET("avx2") static auto match(__m256i v) -> __m256i { return v; }
+  FMT_TARGET("avx512f,avx512bw") static auto match(__m512i v) -> __mmask64 {
+    return _mm512_movepi8_mask(v);
+  }
+#endif
+};
+
+struct brace_kernel {
+  static auto match(unsigned char c) -> bool { return c == '{' || c == '}'; }
+#if FMT_USE_SSE2
+  static auto match(__m128i v) -> __m128i {
+    return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('{')),
+                        _mm_cmpeq_epi8(v, _mm_set1_epi8('}')));
+  }
+#endif
+#if FMT_USE_AVX
+  FMT_TARGET("avx2") static auto match(__m256i v) -> __m256i {
+    return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('{')),
+                           _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}')));
+  }
+  FMT_TARGET("avx512f,avx512bw") static auto match(__m512i v) -> __mmask64 {
+    return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('{')) |
+           _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('}'));
+  }
+#endif
+};
+
+template <typename Kernel>
+auto find_generic(const char* begin, const char* end) -> const char* {
+  while (begin != end && !Kernel::match(static_cast<unsigned char>(*begin)))
+    ++begin;
+  return begin;
+}
+
+#if FMT_USE_SSE2
+template <typename Kernel>
+auto find_sse2(const char* begin, const char* end) -> const char* {
+  for (; end - begin >= 16; begin += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(Kernel::match(v)));
+    if (mask != 0) return begin + first_set_bit(mask);
+  }
+  return find_generic<Kernel>(begin, end);
+}
+#endif
+
+#if FMT_USE_AVX
+template <typename Kernel>
+FMT_TARGET("avx2")
+auto find_avx2(const char* begin, const char* end) -> const char* {
+  for (; end - begin >= 32; begin += 32) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    auto mask = static_cast<unsigned>(_mm256_movemask_epi8(Kernel::match(v)));
+    if (mask != 0) return begin + first_set_bit(mask);
+  }
+  return find_sse2<Kernel>(begin, end);
+}
+
+template <typename Kernel>
+FMT_TARGET("avx512f,avx512bw")
+auto find_avx512(const char* begin, const char* end) -> const char* {
+  for (; end - begin >= 64; begin += 64) {
+    auto mask = Kernel::match(_mm512_loadu_si512(begin));
+    if (mask != 0) return begin + first_set_bit(mask);
+  }
+  return find_avx2<Kernel>(begin, end);
+}
+#endif
+
+inline auto detect_cpu_features() -> cpu_info {
+  auto info = cpu_info();
+  info.sse2 = FMT_USE_SSE2 != 0;
+#if FMT_USE_AVX
+  __builtin_cpu_init();
+  info.avx2 = __builtin_cpu_supports("avx2");
+  info.avx512bw = __builtin_cpu_supports("avx512bw");
+#endif
+  return info;
+}
+
+constexpr const char* simd_level_names[] = {"generic", "sse2", "avx2",
+                                            "avx512"};
+
+// Returns the level requested with the FMT_SIMD environment variable or the
+// highest level if it is not set.
+inline auto requested_simd_level() -> simd_level {
+  FMT_MSC_WARNING(suppress : 4996)
+  const char* name = std::getenv("FMT_SIMD");
+  for (int i = 0; name && i <= static_cast<int>(simd_level::avx512); ++i) {
+    if (std::strcmp(name, simd_level_names[i]) == 0)
+      return static_cast<simd_level>(i);
+  }
+  return simd_level::avx512;
+}
+
+FMT_FUNC auto select_simd_kernels(simd_level level) -> simd_kernels {
+  auto features = detect_cpu_features();
+  ignore_unused(features);
+#if FMT_USE_AVX
+  if (level >= simd_level::avx512 && features.avx512bw) {
+    return {simd_level::avx512, find_avx512<escape_kernel>,
+            find_avx512<non_ascii_kernel>, find_avx512<brace_kernel>};
+  }
+  if (level >= simd_level::avx2 && features.avx2) {
+    return {simd_level::avx2, find_avx2<escape_kernel>,
+            find_avx2<non_ascii_kernel>, find_avx2<brace_kernel>};
+  }
+#endif
+#if FMT_USE_SSE2
+  if (level >= simd_level::sse2) {
+    return {simd_level::sse2, find_sse2<escape_kernel>,
+            find_sse2<non_ascii_kernel>, find_sse2<brace_kernel>};
+  }
+#endif
+  return {simd_level::generic, find_generic<escape_kernel>,
+          find_generic<non_ascii_kernel>, find_generic<brace_kernel>};
+}
+
+FMT_FUNC auto get_simd_kernels() -> const simd_kernels& {
+  static const simd_kernels kernels =
+      select_simd_kernels(requested_simd_level());
+  return kernels;
+}
+
+// A version of parse_format_string for long format strings that skips
+// literal text with a vectorized search for braces.
+template <typename Handler>
+void parse_long_format_string(string_view fmt, Handler&& handler) {
+  auto find_brace = get_simd_kernels().find_brace;
+  auto begin = fmt.data(), end = begin + fmt.size();
+  auto p = begin;
+  while (p != end) {
+    p = find_brace(p, end);
+    if (p == end) break;
+    if (*p++ == '{') {
+      handler.on_text(begin, p - 1);
+      begin = p = parse_replacement_field(p - 1, end, handler);
+    } else {
+      if (p == end || *p != '}')
+        return handler.on_error("unmatched '}' in format string");
+      handler.on_text(begin, p);
+      begin = ++p;
+    }
+  }
+  handler.on_text(begin, end);
+}
+
+inline void do_vformat_to(buffer<char>& buf, string_view fmt,
+                          format_args args, locale_ref loc) {
   auto out = appender(buf);
   if (fmt.size() == 2 && equal2(fmt.data(), "{}"))
     return args.get(0).visit(default_arg_formatter<char>{out});
-  parse_format_string(fmt,
-                      format_handler<>{parse_context<>(fmt), {out, args, loc}});
+  auto handler = format_handler<>{parse_context<>(fmt), {out, args, loc}};
+  if (fmt.size() >= simd_min_size)
+    return parse_long_format_string(fmt, handler);
+  parse_format_string(fmt, handler);
+}
+
+FMT_FUNC void vformat_to(buffer<char>& buf, string_view fmt, format_args args,
+                         locale_ref loc) {
+#if FMT_CAPTURE
+  capture_scope capture(fmt, args);
+#endif
+#if FMT_PROFILE
+  auto sample = profile_begin(fmt);
+  size_t start = buf.size();
+  do_vformat_to(buf, fmt, args, loc);
+  // The size is approximate if the buffer has been flushed during the call.
+  size_t end = buf.size();
+  profile_end(sample, end >= start ? end - start : end);
+#else
+  do_vformat_to(buf, fmt, args, loc);
+#endif
 }
 
 template <typename T> struct span {
@@ -1678,6 +2956,7 @@ class file_print_buffer<F, enable_if_t<has_flockfile<F>::value>>
  public:
   explicit file_print_buffer(F* f) : buffer(grow, size_t()), file_(f) {
     flockfile(f);
+    FMT_ADD_STAT(file_locks, 1);
     file_.init_buffer();
     auto buf = file_.get_write_buffer();
     set(buf.data, buf.size);
@@ -1724,10 +3003,19 @@ FMT_FUNC void print(std::FILE* f, string_view text) {
     if (write_console(fd, text)) return;
   }
 #endif
+  // fwrite locks the file.
+  FMT_ADD_STAT(file_locks, 1);
   fwrite_all(text.data(), text.size(), f);
 }
 }  // namespace detail
 
+FMT_FUNC auto cpu_features() -> cpu_info {
+  auto info = detail::detect_cpu_features();
+  info.kernels = detail::simd_level_names[static_cast<int>(
+      detail::get_simd_kernels().level)];
+  return info;
+}
+
 FMT_FUNC void vprint_buffered(std::FILE* f, string_view fmt, format_args args) {
   auto buffer = memory_buffer();
   detail::vformat_to(buffer, fmt, args);
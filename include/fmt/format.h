@@ -40,6 +40,21 @@
 
 #include "base.h"
 
+// Enables collection of formatting statistics, see fmt::stats.
+#ifndef FMT_STATS
+#  define FMT_STATS 0
+#endif
+
+// Enables the per-call-site profiler, see fmt::dump_profile.
+#ifndef FMT_PROFILE
+#  define FMT_PROFILE 0
+#endif
+
+// Enables capture of formatting calls, see fmt::start_capture.
+#ifndef FMT_CAPTURE
+#  define FMT_CAPTURE 0
+#endif
+
 // libc++ supports string_view in pre-c++17.
 #if FMT_HAS_INCLUDE(<string_view>) && \
     (FMT_CPLUSPLUS >= 201703L || defined(_LIBCPP_VERSION))
@@ -75,6 +90,10 @@
 #  if FMT_MSC_VERSION
 #    include <intrin.h>  // _BitScanReverse[64], _umul128
 #  endif
+
+#  if FMT_STATS || FMT_PROFILE || FMT_CAPTURE
+#    include <atomic>  // std::atomic
+#  endif
 #endif  // FMT_MODULE
 
 #if defined(FMT_USE_NONTYPE_TEMPLATE_ARGS)
@@ -689,6 +708,25 @@ FMT_CONSTEXPR inline auto display_width_of(uint32_t cp) noexcept -> size_t {
             (cp >= 0x1f900 && cp <= 0x1f9ff))));
 }
 
+// Returns the display width of `s` taking the common ASCII case fast.
+inline auto compute_display_width(string_view s) -> size_t {
+  size_t i = 0, n = s.size();
+  while (i < n && static_cast<unsigned char>(s[i]) < 0x80) ++i;
+  if (i == n) return n;
+  size_t width = i;
+  for_each_codepoint({s.data() + i, n - i}, [&](uint32_t cp, string_view) {
+    width += display_width_of(cp);
+    return true;
+  });
+  return width;
+}
+
+// Code units other than char are assumed to have the display width of 1.
+template <typename Char>
+auto compute_display_width(basic_string_view<Char> s) -> size_t {
+  return s.size();
+}
+
 template <typename T> struct is_integral : std::is_integral<T> {};
 template <> struct is_integral<int128_opt> : std::true_type {};
 template <> struct is_integral<uint128_t> : std::true_type {};
@@ -771,10 +809,168 @@ FMT_CONSTEXPR auto maybe_set_debug_format(Formatter& f, bool set)
 template <typename Formatter>
 FMT_CONSTEXPR void maybe_set_debug_format(Formatter&, ...) {}
 
+#if FMT_STATS
+enum class stat {
+  format_calls,
+  allocations,
+  buffer_grows,
+  buffer_grow_bytes,
+  float_fast_path,
+  float_dragon_fallbacks,
+  locale_lookups,
+  file_locks,
+  ostream_flushes,
+  num_stats
+};
+
+// Counters of a single thread. Only the owning thread writes to them, so
+// they are updated without read-modify-write operations and can be read
+// concurrently by fmt::stats.
+struct stats_block {
+  std::atomic<unsigned long long> values[static_cast<int>(stat::num_stats)];
+  std::atomic<bool> in_use;
+  stats_block* next;
+};
+
+// Returns the counters of the current thread or null if they have already
+// been released by the thread exit.
+FMT_API auto local_stats() -> stats_block*;
+
+// Returns the shared counters updated by exiting threads.
+FMT_API auto retired_stats() -> stats_block&;
+
+inline void add_stat(stat s, unsigned long long n) {
+  auto* block = local_stats();
+  if (!block) {
+    // Called from a thread_local destructor after the counters of the thread
+    // have been retired so update the shared block atomically.
+    retired_stats().values[static_cast<int>(s)].fetch_add(
+        n, std::memory_order_relaxed);
+    return;
+  }
+  auto& value = block->values[static_cast<int>(s)];
+  value.store(value.load(std::memory_order_relaxed) + n,
+              std::memory_order_relaxed);
+}
+
+#  define FMT_ADD_STAT(name, n)                   \
+    (fmt::detail::is_constant_evaluated()         \
+         ? void()                                 \
+         : fmt::detail::add_stat(fmt::detail::stat::name, n))
+#else
+#  define FMT_ADD_STAT(name, n) void()
+#endif
+
+#if FMT_PROFILE
+struct profile_entry;
+
+struct profile_sample {
+  profile_entry* entry;
+  unsigned long long start;  // Start time if the call is sampled or 0.
+};
+
+// Starts profiling a formatting call with the format string `fmt`. Call
+// sites are identified by the address of the format string.
+FMT_API auto profile_begin(string_view fmt) -> profile_sample;
+
+// Records the end of a call that produced `size` code units.
+FMT_API void profile_end(profile_sample sample, size_t size);
+#endif
+
 }  // namespace detail
 
 FMT_BEGIN_EXPORT
 
+/**
+ * Formatting statistics. The counters are only updated if {fmt} and the code
+ * using it are compiled with `FMT_STATS=1`. They are monotonic so to export
+ * them to a metrics system take the difference between two snapshots.
+ */
+struct format_stats {
+  /// The number of `fmt::format` and `fmt::vformat` calls.
+  unsigned long long format_calls = 0;
+
+  /// The number of heap allocations made by memory buffers and by strings
+  /// returned from `fmt::format`.
+  unsigned long long allocations = 0;
+
+  /// The number of `basic_memory_buffer` reallocations.
+  unsigned long long buffer_grows = 0;
+
+  /// The number of bytes allocated by `basic_memory_buffer` reallocations.
+  unsigned long long buffer_grow_bytes = 0;
+
+  /// The number of floating-point numbers formatted with Dragonbox or the
+  /// fixed-precision fast path.
+  unsigned long long float_fast_path = 0;
+
+  /// The number of floating-point numbers formatted with the slow Dragon4
+  /// fallback.
+  unsigned long long float_dragon_fallbacks = 0;
+
+  /// The number of digit grouping and thousands separator locale lookups.
+  unsigned long long locale_lookups = 0;
+
+  /// The number of `FILE` locks acquired when printing.
+  unsigned long long file_locks = 0;
+
+  /// The number of `fmt::ostream` buffer flushes.
+  unsigned long long ostream_flushes = 0;
+};
+
+/// Returns formatting statistics aggregated over all threads including the
+/// ones that have exited.
+FMT_API auto stats() -> format_stats;
+
+/// Returns formatting statistics of the current thread.
+FMT_API auto thread_stats() -> format_stats;
+
+/**
+ * Writes the formatting profile to `f`. The profile is only collected if
+ * {fmt} and the code using it are compiled with `FMT_PROFILE=1`.
+ *
+ * Call sites are identified by the address of the format string and are
+ * sorted by the total cost estimated from sampled calls. This shows which
+ * format strings dominate CPU time and output size and are worth converting
+ * to `FMT_COMPILE`.
+ */
+FMT_API void dump_profile(std::FILE* f);
+
+/**
+ * Starts recording formatting calls to the trace file `path`. Every
+ * `sample_rate`-th call is recorded until `max_records` records have been
+ * written. A record consists of the format string and the types, values and
+ * names of the arguments; values of user-defined types are stored as strings
+ * formatted with `{}`. Traces can be replayed with the `replay-bench` tool to
+ * benchmark the library on a real workload.
+ *
+ * Calls are only recorded if {fmt} is compiled with `FMT_CAPTURE=1`,
+ * otherwise this function reports an error.
+ */
+FMT_API void start_capture(const char* path, unsigned sample_rate = 1,
+                           unsigned long long max_records = 100000);
+
+/// Stops recording formatting calls and closes the trace file.
+FMT_API void stop_capture();
+
+/// CPU features detected at runtime and the variant of vectorized kernels
+/// selected based on them.
+struct cpu_info {
+  bool sse2 = false;
+  bool avx2 = false;
+  bool avx512bw = false;
+
+  /// The kernel variant in use: "generic", "sse2", "avx2" or "avx512". It can
+  /// be overridden with the `FMT_SIMD` environment variable, e.g.
+  /// `FMT_SIMD=sse2`, for benchmarking. Variants that are not supported by
+  /// the CPU are replaced with the best supported one.
+  const char* kernels = "generic";
+};
+
+/// Returns the CPU features used to select vectorized kernels. The features
+/// are detected once on first use.
+FMT_API auto cpu_features() -> cpu_info;
+
 // The number of characters to store in the basic_memory_buffer object itself
 // to avoid dynamic memory allocation.
 enum { inline_buffer_size = 500 };
@@ -820,6 +1016,9 @@ class basic_memory_buffer : public detail::buffer<T> {
       new_capacity = max_of(size, max_size);
     T* old_data = buf.data();
     T* new_data = self.alloc_.allocate(new_capacity);
+    FMT_ADD_STAT(buffer_grows, 1);
+    FMT_ADD_STAT(buffer_grow_bytes, new_capacity * sizeof(T));
+    FMT_ADD_STAT(allocations, 1);
     // Suppress a bogus -Wstringop-overflow in gcc 13.1 (#3481).
     detail::assume(buf.size() <= new_capacity);
     // The following code doesn't throw, so the raw pointer above doesn't leak.
@@ -1734,6 +1933,31 @@ auto write_ptr(OutputIt out, UIntPtr value, const format_specs* specs)
                : base_iterator(out, write(reserve(out, size)));
 }
 
+enum class simd_level { generic, sse2, avx2, avx512 };
+
+// Search kernels with variants for different instruction sets that are
+// selected at runtime. Each returns a pointer to the first char in
+// [begin, end) of the given class or end if there is none.
+struct simd_kernels {
+  simd_level level;
+  // Finds a control char, '"', '\\', DEL or a non-ASCII char.
+  auto (*find_escape)(const char* begin, const char* end) -> const char*;
+  // Finds a non-ASCII char.
+  auto (*find_non_ascii)(const char* begin, const char* end) -> const char*;
+  // Finds '{' or '}'.
+  auto (*find_brace)(const char* begin, const char* end) -> const char*;
+};
+
+// Strings shorter than this are searched by scalar code to avoid the
+// overhead of an indirect call.
+enum { simd_min_size = 32 };
+
+// Returns the kernels for `level` or the best supported level below it.
+FMT_API auto select_simd_kernels(simd_level level) -> simd_kernels;
+
+// Returns the kernels selected for this CPU.
+FMT_API auto get_simd_kernels() -> const simd_kernels&;
+
 // Returns true iff the code point cp is printable.
 FMT_API auto is_printable(uint32_t cp) -> bool;
 
@@ -1763,6 +1987,10 @@ auto find_escape(const Char* begin, const Char* end)
 inline auto find_escape(const char* begin, const char* end)
     -> find_escape_result<char> {
   if (const_check(!use_utf8)) return find_escape<char>(begin, end);
+  if (end - begin >= simd_min_size) {
+    begin = get_simd_kernels().find_escape(begin, end);
+    if (begin == end) return {end, nullptr, 0};
+  }
   auto result = find_escape_result<char>{end, nullptr, 0};
   for_each_codepoint(string_view(begin, to_unsigned(end - begin)),
                      [&](uint32_t cp, string_view sv) {
@@ -1898,6 +2126,16 @@ template <typename Char> class digit_grouping {
 
   auto has_separator() const -> bool { return !thousands_sep_.empty(); }
 
+  // Returns the separator if digits are grouped by three with a single
+  // character separator and zero otherwise.
+  auto uniform_separator() const -> Char {
+    if (thousands_sep_.size() != 1 || grouping_.empty()) return Char();
+    for (char group : grouping_) {
+      if (group != 3) return Char();
+    }
+    return thousands_sep_[0];
+  }
+
   auto count_separators(int num_digits) const -> int {
     int count = 0;
     auto state = initial_state();
@@ -1929,6 +2167,56 @@ template <typename Char> class digit_grouping {
   }
 };
 
+// Writes a decimal integer with `sep` between groups of three digits ending
+// at `out` and returns a pointer to the beginning of the output.
+template <typename Char, typename UInt>
+FMT_CONSTEXPR20 auto format_grouped_decimal(Char* out, UInt value, Char sep)
+    -> Char* {
+  while (value >= 1000) {
+    auto n = static_cast<unsigned>(value % 1000);
+    value /= 1000;
+    out -= 3;
+    out[0] = static_cast<Char>('0' + n / 100);
+    write2digits(out + 1, n % 100);
+    *--out = sep;
+  }
+  auto n = static_cast<unsigned>(value);
+  if (n >= 100) {
+    out -= 3;
+    out[0] = static_cast<Char>('0' + n / 100);
+    write2digits(out + 1, n % 100);
+  } else if (n >= 10) {
+    out -= 2;
+    write2digits(out, n);
+  } else {
+    *--out = static_cast<Char>('0' + n);
+  }
+  return out;
+}
+
+// Writes a decimal integer with the common grouping of digits by three in a
+// single pass without computing separator positions.
+template <typename Char, typename OutputIt, typename UInt>
+auto write_grouped_decimal(OutputIt out, UInt value, unsigned prefix,
+                           const format_specs& specs, Char sep) -> OutputIt {
+  int num_digits = count_digits(value);
+  auto digits_size = to_unsigned(num_digits + (num_digits - 1) / 3);
+  unsigned size = (prefix != 0 ? prefix >> 24 : 0) + digits_size;
+  return write_padded<Char, align::right>(
+      out, specs, size, size, [&](reserve_iterator<OutputIt> it) {
+        for (unsigned p = prefix & 0xffffff; p != 0; p >>= 8)
+          *it++ = static_cast<Char>(p & 0xff);
+        if (Char* ptr = to_pointer<Char>(it, digits_size)) {
+          format_grouped_decimal(ptr + digits_size, value, sep);
+          return it;
+        }
+        enum { max_size = digits10<UInt>() + 1 + digits10<UInt>() / 3 };
+        Char buffer[max_size];
+        Char* begin = format_grouped_decimal(buffer + max_size, value, sep);
+        return copy<Char>(begin, buffer + max_size, it);
+      });
+}
+
 FMT_CONSTEXPR inline void prefix_append(unsigned& prefix, unsigned value) {
   prefix |= prefix != 0 ? value << 8 : value;
   prefix += (1u + (value > 0xff ? 1 : 0)) << 24;
@@ -1940,6 +2228,11 @@ auto write_int(OutputIt out, UInt value, unsigned prefix,
                const format_specs& specs, const digit_grouping<Char>& grouping)
     -> OutputIt {
   static_assert(std::is_same<uint64_or_128_t<UInt>, UInt>::value, "");
+  if (specs.type() == presentation_type::none ||
+      specs.type() == presentation_type::dec) {
+    if (Char sep = grouping.uniform_separator())
+      return write_grouped_decimal<Char>(out, value, prefix, specs, sep);
+  }
   int num_digits = 0;
   auto buffer = memory_buffer();
   switch (specs.type()) {
@@ -2181,7 +2474,15 @@ FMT_CONSTEXPR auto write(OutputIt out, basic_string_view<Char> s,
   size_t display_width =
       !is_debug || specs.precision == 0 ? 0 : 1;  // Account for opening '"'.
   size_t size = !is_debug || specs.precision == 0 ? 0 : 1;
-  for_each_codepoint(s, [&](uint32_t cp, string_view sv) {
+  auto rest = s;
+  if (!is_debug && !is_constant_evaluated() && s.size() >= simd_min_size) {
+    // ASCII chars have the display width of 1 and are counted in bulk.
+    auto ascii_end = get_simd_kernels().find_non_ascii(s.begin(), s.end());
+    size = display_width =
+        min_of(to_unsigned(ascii_end - s.begin()), display_width_limit);
+    rest = string_view(s.data() + size, s.size() - size);
+  }
+  for_each_codepoint(rest, [&](uint32_t cp, string_view sv) {
     if (is_debug && needs_escape(cp)) {
       counting_buffer<char> buf;
       write_escaped_cp(basic_appender<char>(buf),
@@ -2288,6 +2589,100 @@ FMT_CONSTEXPR auto write(OutputIt out, const Char* s, const format_specs& specs,
   return write<Char>(out, basic_string_view<Char>(s), specs, {});
 }
 
+// A buffer that writes into the free capacity of another buffer past its
+// end so that the output can be measured and then padded in place. If the
+// output doesn't fit it is moved to a separate memory buffer.
+template <typename Char> class padded_buffer : public buffer<Char> {
+ private:
+  buffer<Char>& target_;
+  basic_memory_buffer<Char> fallback_;
+  bool spilled_ = false;
+
+  static void grow(buffer<Char>& base, size_t capacity) {
+    auto& self = static_cast<padded_buffer&>(base);
+    self.spill();
+    self.fallback_.reserve(capacity);
+    self.set(self.fallback_.data(), self.fallback_.capacity());
+  }
+
+  // Makes fallback_ contain the output.
+  void spill() {
+    if (spilled_) {
+      fallback_.try_resize(this->size());
+      return;
+    }
+    fallback_.append(this->begin(), this->end());
+    spilled_ = true;
+  }
+
+ public:
+  explicit padded_buffer(buffer<Char>& target)
+      : buffer<Char>(grow, target.end(), 0, target.capacity() - target.size()),
+        target_(target) {}
+
+  // Writes the output to the target buffer padded according to `specs`.
+  // Precision and presentation type in `specs` are ignored.
+  void commit(const format_specs& specs) {
+    size_t size = this->size();
+    size_t width =
+        compute_display_width(basic_string_view<Char>(this->data(), size));
+    unsigned spec_width = to_unsigned(specs.width);
+    size_t padding = spec_width > width ? spec_width - width : 0;
+    size_t fill_size = specs.fill_size();
+    if (!spilled_ && size + padding * fill_size > this->capacity()) spill();
+    if (spilled_) {
+      spill();
+      const Char* data = fallback_.data();
+      write_padded<Char>(basic_appender<Char>(target_), specs, size, width,
+                         [=](basic_appender<Char> it) {
+                           return copy<Char>(data, data + size, it);
+                         });
+      return;
+    }
+    Char* data = this->data();
+    if (padding != 0) {
+      auto* shifts = "\x1f\x1f\x00\x01";
+      size_t left_padding = padding >> shifts[static_cast<int>(specs.align())];
+      std::memmove(data + left_padding * fill_size, data, size * sizeof(Char));
+      fill<Char>(data, left_padding, specs);
+      fill<Char>(data + left_padding * fill_size + size, padding - left_padding,
+                 specs);
+    }
+    target_.try_resize(target_.size() + size + padding * fill_size);
+  }
+};
+
+// Writes the output of `f` called with basic_appender<Char> to `out`
+// padded according to `specs`. If `out` appends to a buffer, the output is
+// written directly to it and padded in place instead of being copied from a
+// temporary buffer. `size_hint` is the expected output size in code units.
+template <typename Char, typename OutputIt, typename F,
+          FMT_ENABLE_IF(std::is_same<OutputIt, basic_appender<Char>>::value)>
+auto write_padded_output(OutputIt out, const format_specs& specs, F f,
+                         size_t size_hint = 0) -> OutputIt {
+  if (specs.width == 0) return f(out);
+  auto& target = get_container(out);
+  // Reserve enough space for the padding, the most common case being short
+  // output padded to a fixed width.
+  size_t padded_size = to_unsigned(specs.width) * specs.fill_size();
+  target.try_reserve(target.size() + max_of(padded_size, size_hint));
+  padded_buffer<Char> buf(target);
+  f(basic_appender<Char>(buf));
+  buf.commit(specs);
+  return out;
+}
+
+template <typename Char, typename OutputIt, typename F,
+          FMT_ENABLE_IF(!std::is_same<OutputIt, basic_appender<Char>>::value)>
+auto write_padded_output(OutputIt out, const format_specs& specs, F f,
+                         size_t size_hint = 0) -> OutputIt {
+  auto buf = basic_memory_buffer<Char>();
+  buf.reserve(size_hint);
+  f(basic_appender<Char>(buf));
+  return write<Char>(out, basic_string_view<Char>(buf.data(), buf.size()),
+                     specs);
+}
+
 template <typename Char, typename OutputIt, typename T,
           FMT_ENABLE_IF(is_integral<T>::value &&
                         !std::is_same<T, bool>::value &&
@@ -3428,6 +3823,9 @@ FMT_CONSTEXPR20 auto format_float(Float value, int precision,
     const int max_double_digits = 767;
     if (precision > max_double_digits) precision = max_double_digits;
     format_dragon(f, dragon_flags, precision, buf, exp);
+    FMT_ADD_STAT(float_dragon_fallbacks, 1);
+  } else {
+    FMT_ADD_STAT(float_fast_path, 1);
   }
   if (!fixed && !specs.alt()) {
     // Remove trailing zeros.
@@ -3467,6 +3865,7 @@ FMT_CONSTEXPR20 auto write(OutputIt out, T value, format_specs specs,
     } else if (is_fast_float<T>::value && !is_constant_evaluated()) {
       // Use Dragonbox for the shortest format.
       auto dec = dragonbox::to_decimal(static_cast<fast_float_t<T>>(value));
+      FMT_ADD_STAT(float_fast_path, 1);
       return write_float<Char>(out, dec, specs, s, exp_upper, loc);
     }
   }
@@ -3509,6 +3908,7 @@ FMT_CONSTEXPR20 auto write(OutputIt out, T value) -> OutputIt {
     return write_nonfinite<Char>(out, std::isnan(value), {}, s);
 
   auto dec = dragonbox::to_decimal(static_cast<fast_float_t<T>>(value));
+  FMT_ADD_STAT(float_fast_path, 1);
   auto significand = dec.significand;
   int significand_size = count_digits(significand);
   int exponent = dec.exponent + significand_size - 1;
@@ -3825,6 +4225,79 @@ FMT_CONSTEXPR auto native_formatter<T, Char, TYPE>::format(
                       specs_.precision_ref, ctx);
   return write<Char>(ctx.out(), val, specs, ctx.locale());
 }
+
+#ifndef FMT_HEADER_ONLY
+// The hot writers and formatters of built-in types are instantiated for char
+// in the library to reduce compile time and duplicate code.
+FMT_BEGIN_EXPORT
+#  if !FMT_REDUCE_INT_INSTANTIATIONS
+extern template FMT_API auto write_int_noinline<char>(
+    appender, write_int_arg<uint32_t>, const format_specs&) -> appender;
+#  endif
+extern template FMT_API auto write_int(appender, uint64_t, unsigned,
+                                       const format_specs&,
+                                       const digit_grouping<char>&)
+    -> appender;
+extern template FMT_API auto write_int(appender, uint128_t, unsigned,
+                                       const format_specs&,
+                                       const digit_grouping<char>&)
+    -> appender;
+extern template FMT_API auto write_int_noinline<char>(
+    appender, write_int_arg<uint64_t>, const format_specs&) -> appender;
+extern template FMT_API auto write_int_noinline<char>(
+    appender, write_int_arg<uint128_t>, const format_specs&) -> appender;
+extern template FMT_API auto write<char>(appender, string_view,
+                                         const format_specs&) -> appender;
+extern template FMT_API auto write<char>(appender, float, format_specs,
+                                         locale_ref) -> appender;
+extern template FMT_API auto write<char>(appender, double, format_specs,
+                                         locale_ref) -> appender;
+extern template FMT_API auto write<char>(appender, long double, format_specs,
+                                         locale_ref) -> appender;
+extern template FMT_API auto write<char>(appender, float) -> appender;
+extern template FMT_API auto write<char>(appender, double) -> appender;
+
+extern template FMT_API auto
+native_formatter<int, char, type::int_type>::format(const int&,
+                                                    format_context&) const
+    -> appender;
+extern template FMT_API auto
+native_formatter<unsigned, char, type::uint_type>::format(
+    const unsigned&, format_context&) const -> appender;
+extern template FMT_API auto
+native_formatter<long long, char, type::long_long_type>::format(
+    const long long&, format_context&) const -> appender;
+extern template FMT_API auto
+native_formatter<unsigned long long, char, type::ulong_long_type>::format(
+    const unsigned long long&, format_context&) const -> appender;
+extern template FMT_API auto
+native_formatter<bool, char, type::bool_type>::format(const bool&,
+                                                      format_context&) const
+    -> appender;
+extern template FMT_API auto
+native_formatter<char, char, type::char_type>::format(const char&,
+                                                      format_context&) const
+    -> appender;
+extern template FMT_API auto
+native_formatter<float, char, type::float_type>::format(
+    const float&, format_context&) const -> appender;
+extern template FMT_API auto
+native_formatter<double, char, type::double_type>::format(
+    const double&, format_context&) const -> appender;
+extern template FMT_API auto
+native_formatter<long double, char, type::long_double_type>::format(
+    const long double&, format_context&) const -> appender;
+extern template FMT_API auto
+native_formatter<const char*, char, type::cstring_type>::format(
+    const char* const&, format_context&) const -> appender;
+extern template FMT_API auto
+native_formatter<string_view, char, type::string_type>::format(
+    const string_view&, format_context&) const -> appender;
+extern template FMT_API auto
+native_formatter<const void*, char, type::pointer_type>::format(
+    const void* const&, format_context&) const -> appender;
+FMT_END_EXPORT
+#endif  // FMT_HEADER_ONLY
 }  // namespace detail
 
 FMT_BEGIN_EXPORT
@@ -3869,6 +4342,15 @@ template <typename OutputIt, typename Char> class generic_context {
   }
 
   constexpr auto locale() const -> locale_ref { return loc_; }
+
+  /// Returns a pointer to space for `n` characters at the end of the output or
+  /// null if the output is not contiguous, see `context::reserve`.
+  auto reserve(size_t n) -> Char* {
+    return detail::reserve_output<Char>(out_, n);
+  }
+
+  /// Completes the write started with `reserve`.
+  void commit(Char* end) { detail::commit_output<Char>(out_, end); }
 };
 
 class loc_value {
@@ -4074,12 +4556,185 @@ template <typename T> struct formatter<group_digits_view<T>> : formatter<T> {
     detail::handle_dynamic_spec(specs.dynamic_precision(), specs.precision,
                                 specs.precision_ref, ctx);
     auto arg = detail::make_write_int_arg(view.value, specs.sign());
-    return detail::write_int(
-        ctx.out(), static_cast<detail::uint64_or_128_t<T>>(arg.abs_value),
-        arg.prefix, specs, detail::digit_grouping<char>("\3", ","));
+    auto value = static_cast<detail::uint64_or_128_t<T>>(arg.abs_value);
+    if (specs.type() == presentation_type::none ||
+        specs.type() == presentation_type::dec) {
+      return detail::write_grouped_decimal<char>(ctx.out(), value, arg.prefix,
+                                                 specs, ',');
+    }
+    return detail::write_int(ctx.out(), value, arg.prefix, specs,
+                             detail::digit_grouping<char>("\3", ","));
+  }
+};
+
+/**
+ * A view of an arbitrary-precision integer given by an array of 64-bit limbs
+ * with the least significant limb first and a sign. It is formatted with the
+ * integer format specifiers except for `c` and `L` and can be wrapped in
+ * `fmt::group_digits`. Decimal conversion uses a subquadratic
+ * divide-and-conquer algorithm for large numbers.
+ *
+ * **Example**:
+ *
+ *     uint64_t limbs[] = {0, 1};  // 2^64
+ *     fmt::print("{} {:#x}", fmt::bigint_view(limbs, 2),
+ *                fmt::bigint_view(limbs, 2, true));
+ *     // Output: "18446744073709551616 -0x10000000000000000"
+ */
+struct bigint_view {
+  const uint64_t* limbs;
+  size_t size;
+  bool negative;
+
+  constexpr bigint_view(const uint64_t* l, size_t n, bool neg = false)
+      : limbs(l), size(n), negative(neg) {}
+
+  /// Constructs a view of a contiguous range of limbs such as `std::vector`.
+  template <typename Range,
+            FMT_ENABLE_IF(std::is_convertible<
+                          decltype(std::declval<const Range&>().data()),
+                          const uint64_t*>::value)>
+  bigint_view(const Range& r, bool neg = false)
+      : bigint_view(r.data(), r.size(), neg) {}
+};
+
+namespace detail {
+// Appends the digits of an integer given by 64-bit limbs in little-endian
+// order to out.
+FMT_API void format_bigint_decimal(memory_buffer& out, const uint64_t* limbs,
+                                   size_t size);
+FMT_API void format_bigint_base2e(memory_buffer& out, const uint64_t* limbs,
+                                  size_t size, int bits, bool upper);
+
+template <typename OutputIt>
+auto write_bigint(OutputIt out, bigint_view value, const format_specs& specs,
+                  bool grouped) -> OutputIt {
+  size_t size = value.size;
+  while (size > 0 && value.limbs[size - 1] == 0) --size;
+  auto prefix = 0u;
+  if (value.negative && size != 0) {
+    prefix = 0x01000000 | '-';
+  } else {
+    constexpr unsigned prefixes[4] = {0, 0, 0x1000000u | '+', 0x1000000u | ' '};
+    prefix = prefixes[static_cast<int>(specs.sign())];
+  }
+  auto digits = memory_buffer();
+  switch (specs.type()) {
+  default: report_error("invalid format specifier");
+  case presentation_type::none:
+  case presentation_type::dec:
+    format_bigint_decimal(digits, value.limbs, size);
+    break;
+  case presentation_type::hex:
+    if (specs.alt())
+      prefix_append(prefix, unsigned(specs.upper() ? 'X' : 'x') << 8 | '0');
+    format_bigint_base2e(digits, value.limbs, size, 4, specs.upper());
+    break;
+  case presentation_type::oct:
+    if (specs.alt() && size != 0) prefix_append(prefix, '0');
+    format_bigint_base2e(digits, value.limbs, size, 3, false);
+    break;
+  case presentation_type::bin:
+    if (specs.alt())
+      prefix_append(prefix, unsigned(specs.upper() ? 'B' : 'b') << 8 | '0');
+    format_bigint_base2e(digits, value.limbs, size, 1, false);
+    break;
+  }
+
+  size_t num_digits = digits.size();
+  size_t num_separators = grouped ? (num_digits - 1) / 3 : 0;
+  size_t output_size =
+      (prefix != 0 ? prefix >> 24 : 0) + num_digits + num_separators;
+  size_t zeros = 0;
+  if (specs.align() == align::numeric &&
+      to_unsigned(specs.width) > output_size) {
+    zeros = to_unsigned(specs.width) - output_size;
+    output_size = to_unsigned(specs.width);
+  }
+  return write_padded<char, align::right>(
+      out, specs, output_size, output_size,
+      [&](reserve_iterator<OutputIt> it) {
+        for (unsigned p = prefix & 0xffffff; p != 0; p >>= 8)
+          *it++ = static_cast<char>(p & 0xff);
+        it = detail::fill_n(it, zeros, '0');
+        const char* data = digits.data();
+        if (!grouped) return copy<char>(data, data + num_digits, it);
+        size_t first = num_digits - num_separators * 3;
+        it = copy<char>(data, data + first, it);
+        for (size_t i = first; i < num_digits; i += 3) {
+          *it++ = ',';
+          it = copy<char>(data + i, data + i + 3, it);
+        }
+        return it;
+      });
+}
+}  // namespace detail
+
+template <> struct formatter<bigint_view> {
+ private:
+  detail::dynamic_format_specs<> specs_;
+
+ protected:
+  template <typename FormatContext>
+  auto do_format(bigint_view value, FormatContext& ctx, bool grouped) const
+      -> decltype(ctx.out()) {
+    auto specs = specs_;
+    detail::handle_dynamic_spec(specs.dynamic_width(), specs.width,
+                                specs.width_ref, ctx);
+    return detail::write_bigint(ctx.out(), value, specs, grouped);
+  }
+
+ public:
+  FMT_CONSTEXPR auto parse(parse_context<>& ctx) -> const char* {
+    auto end = parse_format_specs(ctx.begin(), ctx.end(), specs_, ctx,
+                                  detail::type::int_type);
+    if (specs_.localized()) report_error("invalid format specifier");
+    return end;
+  }
+
+  template <typename FormatContext>
+  auto format(bigint_view value, FormatContext& ctx) const
+      -> decltype(ctx.out()) {
+    return do_format(value, ctx, false);
   }
 };
 
+template <>
+struct formatter<group_digits_view<bigint_view>> : formatter<bigint_view> {
+  template <typename FormatContext>
+  auto format(group_digits_view<bigint_view> view, FormatContext& ctx) const
+      -> decltype(ctx.out()) {
+    return do_format(view.value, ctx, true);
+  }
+};
+
+/**
+ * Writes the output of `write`, called with an output iterator, to the
+ * context padded according to the fill, alignment and width in `specs`.
+ * Precision and presentation type are ignored. The output is written once,
+ * directly to the context buffer when possible, and padded in place there.
+ * `size_hint` is the expected output size in code units used to reserve
+ * buffer space.
+ *
+ * **Example**:
+ *
+ *     auto format(const point& p, format_context& ctx) const {
+ *       auto specs = fmt::format_specs();
+ *       specs.width = 20;
+ *       specs.set_align(fmt::align::center);
+ *       return fmt::format_padded(ctx, specs, [&](auto out) {
+ *         return fmt::format_to(out, "({}, {})", p.x, p.y);
+ *       });
+ *     }
+ */
+template <typename FormatContext, typename F>
+auto format_padded(FormatContext& ctx, const format_specs& specs, F write,
+                   size_t size_hint = 0) -> decltype(ctx.out()) {
+  using char_type = typename FormatContext::char_type;
+  return detail::write_padded_output<char_type>(ctx.out(), specs, write,
+                                                size_hint);
+}
+
 template <typename T, typename Char> struct nested_view {
   const formatter<T, Char>* fmt;
   const T* value;
@@ -4122,17 +4777,17 @@ template <typename T, typename Char = char> struct nested_formatter {
     return formatter_.parse(ctx);
   }
 
+  // Writes the output of `write` padded to the parsed width. `size_hint` is
+  // the expected output size used to reserve buffer space.
   template <typename FormatContext, typename F>
-  auto write_padded(FormatContext& ctx, F write) const -> decltype(ctx.out()) {
+  auto write_padded(FormatContext& ctx, F write, size_t size_hint = 0) const
+      -> decltype(ctx.out()) {
     if (width_ == 0) return write(ctx.out());
-    auto buf = basic_memory_buffer<Char>();
-    write(basic_appender<Char>(buf));
     auto specs = format_specs();
     specs.width = width_;
     specs.copy_fill_from(specs_);
     specs.set_align(specs_.align());
-    return detail::write<Char>(
-        ctx.out(), basic_string_view<Char>(buf.data(), buf.size()), specs);
+    return format_padded(ctx, specs, write, size_hint);
   }
 
   auto nested(const T& value) const -> nested_view<T, Char> {
@@ -4298,6 +4953,8 @@ inline auto vformat(locale_ref loc, string_view fmt, format_args args)
     -> std::string {
   auto buf = memory_buffer();
   detail::vformat_to(buf, fmt, args, loc);
+  FMT_ADD_STAT(format_calls, 1);
+  FMT_ADD_STAT(allocations, buf.size() > std::string().capacity() ? 1 : 0);
   return {buf.data(), buf.size()};
 }
 
@@ -4332,6 +4989,177 @@ FMT_NODISCARD FMT_INLINE auto formatted_size(locale_ref loc,
   return buf.count();
 }
 
+/// A streaming 64-bit FNV-1a hasher for `format_hash`.
+class fnv1a_hasher {
+ private:
+  uint64_t hash_ = 0xcbf29ce484222325;
+
+ public:
+  FMT_CONSTEXPR void update(const char* data, size_t size) noexcept {
+    for (size_t i = 0; i < size; ++i) {
+      hash_ ^= static_cast<unsigned char>(data[i]);
+      hash_ *= 0x100000001b3;
+    }
+  }
+
+  constexpr auto digest() const noexcept -> uint64_t { return hash_; }
+};
+
+namespace detail {
+constexpr uint64_t xxh64_prime1 = 0x9e3779b185ebca87;
+constexpr uint64_t xxh64_prime2 = 0xc2b2ae3d27d4eb4f;
+constexpr uint64_t xxh64_prime3 = 0x165667b19e3779f9;
+constexpr uint64_t xxh64_prime4 = 0x85ebca77c2b2ae63;
+constexpr uint64_t xxh64_prime5 = 0x27d4eb2f165667c5;
+
+inline auto rotl64(uint64_t x, int r) noexcept -> uint64_t {
+  return (x << r) | (x >> (64 - r));
+}
+
+template <int N>
+inline auto read_le(const unsigned char* p) noexcept -> uint64_t {
+  uint64_t result = 0;
+  for (int i = 0; i < N; ++i) result |= uint64_t(p[i]) << (i * 8);
+  return result;
+}
+
+inline auto xxh64_round(uint64_t acc, uint64_t input) noexcept -> uint64_t {
+  return rotl64(acc + input * xxh64_prime2, 31) * xxh64_prime1;
+}
+
+inline auto xxh64_merge(uint64_t acc, uint64_t value) noexcept -> uint64_t {
+  return (acc ^ xxh64_round(0, value)) * xxh64_prime1 + xxh64_prime4;
+}
+}  // namespace detail
+
+/**
+ * A streaming hasher that computes XXH64, the 64-bit variant of xxHash, for
+ * `format_hash`. The result doesn't depend on how the input is split into
+ * `update` calls.
+ */
+class xxhash64_hasher {
+ private:
+  enum { stripe_size = 32 };
+  uint64_t acc_[4];
+  uint64_t seed_;
+  uint64_t total_size_ = 0;
+  unsigned char tail_[stripe_size];
+  size_t tail_size_ = 0;
+
+  void consume(const unsigned char* stripe) noexcept {
+    for (int i = 0; i < 4; ++i) {
+      uint64_t input = detail::read_le<8>(stripe + i * 8);
+      acc_[i] = detail::xxh64_round(acc_[i], input);
+    }
+  }
+
+ public:
+  explicit xxhash64_hasher(uint64_t seed = 0) noexcept : seed_(seed) {
+    acc_[0] = seed + detail::xxh64_prime1 + detail::xxh64_prime2;
+    acc_[1] = seed + detail::xxh64_prime2;
+    acc_[2] = seed;
+    acc_[3] = seed - detail::xxh64_prime1;
+  }
+
+  void update(const char* data, size_t size) noexcept {
+    auto p = reinterpret_cast<const unsigned char*>(data);
+    total_size_ += size;
+    if (tail_size_ != 0) {
+      size_t n = min_of(size, stripe_size - tail_size_);
+      std::memcpy(tail_ + tail_size_, p, n);
+      tail_size_ += n;
+      p += n;
+      size -= n;
+      if (tail_size_ < stripe_size) return;
+      consume(tail_);
+      tail_size_ = 0;
+    }
+    for (; size >= stripe_size; p += stripe_size, size -= stripe_size)
+      consume(p);
+    if (size != 0) std::memcpy(tail_, p, size);
+    tail_size_ = size;
+  }
+
+  auto digest() const noexcept -> uint64_t {
+    using namespace detail;
+    uint64_t h = seed_ + xxh64_prime5;
+    if (total_size_ >= stripe_size) {
+      h = rotl64(acc_[0], 1) + rotl64(acc_[1], 7) + rotl64(acc_[2], 12) +
+          rotl64(acc_[3], 18);
+      for (uint64_t acc : acc_) h = xxh64_merge(h, acc);
+    }
+    h += total_size_;
+    const unsigned char* p = tail_;
+    const unsigned char* end = tail_ + tail_size_;
+    for (; end - p >= 8; p += 8) {
+      h ^= xxh64_round(0, read_le<8>(p));
+      h = rotl64(h, 27) * xxh64_prime1 + xxh64_prime4;
+    }
+    if (end - p >= 4) {
+      h ^= read_le<4>(p) * xxh64_prime1;
+      h = rotl64(h, 23) * xxh64_prime2 + xxh64_prime3;
+      p += 4;
+    }
+    for (; p != end; ++p) {
+      h ^= *p * xxh64_prime5;
+      h = rotl64(h, 11) * xxh64_prime1;
+    }
+    h ^= h >> 33;
+    h *= xxh64_prime2;
+    h ^= h >> 29;
+    h *= xxh64_prime3;
+    return h ^ (h >> 32);
+  }
+};
+
+namespace detail {
+// A buffer that passes full chunks of the output to a hasher.
+template <typename Hasher> class hashing_buffer : public buffer<char> {
+ private:
+  enum { buffer_size = 256 };
+  char data_[buffer_size];
+  Hasher& hasher_;
+
+  static void grow(buffer<char>& buf, size_t) {
+    if (buf.size() != buffer_size) return;
+    auto& self = static_cast<hashing_buffer&>(buf);
+    self.hasher_.update(self.data_, buffer_size);
+    buf.clear();
+  }
+
+ public:
+  explicit hashing_buffer(Hasher& h)
+      : buffer<char>(grow, data_, 0, buffer_size), hasher_(h) {}
+
+  void flush() {
+    hasher_.update(data_, size());
+    clear();
+  }
+};
+}  // namespace detail
+
+/**
+ * Formats `args` according to specifications in `fmt` and returns the hash
+ * of the output computed without storing it. The output is streamed through
+ * a small fixed-size buffer into a default-constructed `Hasher` which must
+ * provide `update(const char* data, size_t size)` and `digest()`.
+ * `fmt::fnv1a_hasher` and `fmt::xxhash64_hasher` are provided.
+ *
+ * **Example**:
+ *
+ *     uint64_t key = fmt::format_hash<fmt::xxhash64_hasher>(
+ *         "{}:{}", "user", 42);
+ */
+template <typename Hasher = fnv1a_hasher, typename... T>
+FMT_NODISCARD auto format_hash(format_string<T...> fmt, T&&... args)
+    -> decltype(std::declval<const Hasher&>().digest()) {
+  auto hasher = Hasher();
+  detail::hashing_buffer<Hasher> buf(hasher);
+  detail::vformat_to(buf, fmt.str, vargs<T...>{{args...}}, {});
+  buf.flush();
+  return hasher.digest();
+}
+
 FMT_API auto vformat(string_view fmt, format_args args) -> std::string;
 
 /**
@@ -15,6 +15,7 @@
 #  include <cstddef>
 #  include <cstdio>
 #  include <system_error>  // std::system_error
+#  include <vector>
 
 #  if FMT_HAS_INCLUDE(<xlocale.h>)
 #    include <xlocale.h>  // LC_NUMERIC_MASK on macOS
@@ -38,6 +39,14 @@
 #  endif
 #endif
 
+#ifndef FMT_USE_MMAP
+#  if FMT_USE_FCNTL && !defined(_WIN32) && FMT_HAS_INCLUDE(<sys/mman.h>)
+#    define FMT_USE_MMAP 1
+#  else
+#    define FMT_USE_MMAP 0
+#  endif
+#endif
+
 #ifndef FMT_POSIX
 #  if defined(_WIN32) && !defined(__MINGW32__)
 // Fix warnings about deprecated symbols.
@@ -286,6 +295,10 @@ class FMT_API file {
   // Attempts to write count bytes from the specified buffer to the file.
   auto write(const void* buffer, size_t count) -> size_t;
 
+  // Attempts to write count bytes to a file in non-blocking mode. Returns
+  // the number of bytes written or 0 if the write would block.
+  auto try_write(const void* buffer, size_t count) -> size_t;
+
   // Duplicates a file descriptor with the dup function and returns
   // the duplicate as a file object.
   static auto dup(int fd) -> file;
@@ -321,6 +334,13 @@ struct FMT_API pipe {
 // Returns the memory page size.
 auto getpagesize() -> long;
 
+/// Compression of the output written with `fmt::ostream`.
+enum class compression {
+  none,
+  /// A fast LZ77 codec with independently compressed blocks.
+  fast
+};
+
 namespace detail {
 
 struct buffer_size {
@@ -333,44 +353,101 @@ struct buffer_size {
   }
 };
 
+struct compress_param {
+  constexpr compress_param() = default;
+  compression value = compression::none;
+  FMT_CONSTEXPR auto operator=(compression val) const -> compress_param {
+    auto cp = compress_param();
+    cp.value = val;
+    return cp;
+  }
+};
+
+struct nonblocking_t {};
+
+// The state of the block compressor used by ostream.
+class compressor;
+
 struct ostream_params {
   int oflag = file::WRONLY | file::CREATE | file::TRUNC;
   size_t buffer_size = BUFSIZ > 32768 ? BUFSIZ : 32768;
+  compression compress = compression::none;
+  bool nonblocking = false;
 
   constexpr ostream_params() {}
 
-  template <typename... T>
-  ostream_params(T... params, int new_oflag) : ostream_params(params...) {
-    oflag = new_oflag;
+  template <typename... T> ostream_params(T... params) {
+    int dummy[] = {0, (set(params), 0)...};
+    ignore_unused(dummy);
   }
 
-  template <typename... T>
-  ostream_params(T... params, detail::buffer_size bs)
-      : ostream_params(params...) {
-    this->buffer_size = bs.value;
-  }
-
-// Intel has a bug that results in failure to deduce a constructor
-// for empty parameter packs.
-#  if defined(__INTEL_COMPILER) && __INTEL_COMPILER < 2000
-  ostream_params(int new_oflag) : oflag(new_oflag) {}
-  ostream_params(detail::buffer_size bs) : buffer_size(bs.value) {}
-#  endif
+  void set(int new_oflag) { oflag = new_oflag; }
+  void set(detail::buffer_size bs) { buffer_size = bs.value; }
+  void set(detail::compress_param c) { compress = c.value; }
+  void set(detail::nonblocking_t) { nonblocking = true; }
 };
 
 }  // namespace detail
 
 FMT_INLINE_VARIABLE constexpr auto buffer_size = detail::buffer_size();
+FMT_INLINE_VARIABLE constexpr auto compress = detail::compress_param();
+FMT_INLINE_VARIABLE constexpr auto nonblocking = detail::nonblocking_t();
+
+class ostream;
+class file_contents;
+
+namespace detail {
+template <typename T, FMT_ENABLE_IF(!std::is_same<remove_const_t<T>,
+                                                  file_contents>::value)>
+auto splice_file_contents(ostream&, T& arg) noexcept -> T& {
+  return arg;
+}
+
+#  if FMT_USE_MMAP
+struct ostream_file_contents;
+
+// Replaces file_contents arguments of ostream::print with a reference to the
+// stream, so that they can be written without copying into the buffer.
+inline auto splice_file_contents(ostream& out, const file_contents& fc) noexcept
+    -> ostream_file_contents;
+#  endif
+}  // namespace detail
 
-/// A fast buffered output stream for writing from a single thread. Writing from
-/// multiple threads without external synchronization may result in a data race.
+/**
+ * A fast buffered output stream for writing from a single thread. Writing from
+ * multiple threads without external synchronization may result in a data race.
+ *
+ * In non-blocking mode output that cannot be written because the file would
+ * block is queued instead, so formatting never waits for the file. The queue
+ * is drained by `try_flush` and output still queued when the stream is
+ * closed or destroyed is discarded.
+ */
 class ostream : private detail::buffer<char> {
  private:
   file file_;
+  detail::compressor* compressor_ = nullptr;
+  bool nonblocking_ = false;
+  std::vector<char> pending_;  // Output not written because of EAGAIN.
+  size_t pending_begin_ = 0;   // Offset of the unwritten part of pending_.
 
   FMT_API ostream(cstring_view path, const detail::ostream_params& params);
+  FMT_API ostream(file f, const detail::ostream_params& params);
 
   FMT_API static void grow(buffer<char>& buf, size_t);
+  FMT_API void write_buffer();
+  void write_data(const char* data, size_t size);
+
+  // Binds the spliced arguments to names because format arguments are stored
+  // as references to lvalues.
+  template <typename... T> void print_spliced(string_view fmt, T&&... args) {
+    vformat_to(appender(*this), fmt, vargs<T...>{{args...}});
+  }
+
+#  if FMT_USE_MMAP
+  FMT_API void write_file_contents(const file_contents& fc);
+
+  friend struct formatter<detail::ostream_file_contents>;
+#  endif
 
  public:
   FMT_API ostream(ostream&& other) noexcept;
@@ -383,12 +460,42 @@ class ostream : private detail::buffer<char> {
 
   inline void flush() {
     if (size() == 0) return;
-    file_.write(data(), size() * sizeof(data()[0]));
+    FMT_ADD_STAT(ostream_flushes, 1);
+    if (compressor_ || nonblocking_)
+      write_buffer();
+    else
+      file_.write(data(), size() * sizeof(data()[0]));
     clear();
   }
 
+  /**
+   * Writes as much of the buffered and queued output as possible without
+   * blocking. Returns true if all output has been written.
+   */
+  FMT_API auto try_flush() -> bool;
+
+  /**
+   * Returns the number of bytes that haven't been written to the file yet.
+   * With compression, buffered output is counted before compression and
+   * queued output after it.
+   */
+  auto pending_bytes() const noexcept -> size_t {
+    return size() + (pending_.size() - pending_begin_);
+  }
+
+  /**
+   * Returns true if output is queued because the file was not ready for
+   * writing. The caller should wait until the file becomes writable, e.g.
+   * with `EPOLLOUT`, and call `try_flush`.
+   */
+  auto want_write() const noexcept -> bool {
+    return pending_begin_ != pending_.size();
+  }
+
   template <typename... T>
   friend auto output_file(cstring_view path, T... params) -> ostream;
+  template <typename... T>
+  friend auto output_file(file f, T... params) -> ostream;
 
   inline void close() {
     flush();
@@ -398,7 +505,7 @@ class ostream : private detail::buffer<char> {
   /// Formats `args` according to specifications in `fmt` and writes the
   /// output to the file.
   template <typename... T> void print(format_string<T...> fmt, T&&... args) {
-    vformat_to(appender(*this), fmt.str, vargs<T...>{{args...}});
+    print_spliced(fmt.str, detail::splice_file_contents(*this, args)...);
   }
 };
 
@@ -409,6 +516,11 @@ class ostream : private detail::buffer<char> {
  *   https://pubs.opengroup.org/onlinepubs/007904875/functions/open.html)
  *   (`file::WRONLY | file::CREATE | file::TRUNC` by default)
  * - `buffer_size=<integer>`: Output buffer size
+ * - `compress=<compression>`: Output compression. With
+ *   `compression::fast` each flushed buffer is compressed and written as a
+ *   separate block that can be read back with `fmt::input_file`.
+ * - `nonblocking`: Non-blocking mode for files opened with `O_NONBLOCK`,
+ *   see `fmt::ostream`
  *
  * **Example**:
  *
@@ -419,6 +531,174 @@ template <typename... T>
 inline auto output_file(cstring_view path, T... params) -> ostream {
   return {path, detail::ostream_params(params...)};
 }
+
+/**
+ * Creates an output stream writing to the open file `f`, e.g. a socket.
+ * Supported parameters are the same as in `output_file(path, params...)`
+ * except for the open flags.
+ *
+ * **Example**:
+ *
+ *     auto out = fmt::output_file(fmt::file::dup(sock), fmt::nonblocking);
+ *     out.print("HTTP/1.1 200 OK\r\n");
+ *     if (!out.try_flush()) {
+ *       // Wait for EPOLLOUT and call out.try_flush() again.
+ *     }
+ */
+template <typename... T>
+inline auto output_file(file f, T... params) -> ostream {
+  return {std::move(f), detail::ostream_params(params...)};
+}
+
+#  if FMT_USE_MMAP
+/**
+ * A range of the contents of a regular file to be formatted as a string. The
+ * range is clamped to the end of the file. `fmt::ostream` transfers it to its
+ * file in the kernel with `copy_file_range` or `sendfile` where available
+ * after flushing buffered output. Other destinations get a copy made from a
+ * memory mapping of the file.
+ *
+ * **Example**:
+ *
+ *     auto tmpl = fmt::file("header.html", fmt::file::RDONLY);
+ *     auto out = fmt::output_file("index.html");
+ *     out.print("{}<p>{}</p>\n", fmt::file_contents(tmpl), text);
+ */
+class file_contents {
+ private:
+  const file* file_;
+  long long offset_;
+  size_t size_;
+
+ public:
+  file_contents(const file& f, long long offset = 0,
+                size_t size = detail::max_value<size_t>()) noexcept
+      : file_(&f), offset_(offset), size_(size) {}
+
+  auto get_file() const noexcept -> const file& { return *file_; }
+  auto offset() const noexcept -> long long { return offset_; }
+  auto size() const noexcept -> size_t { return size_; }
+};
+
+namespace detail {
+// Appends the contents of a file range to a buffer.
+FMT_API void write_file_contents(buffer<char>& buf, const file_contents& fc);
+
+struct ostream_file_contents {
+  ostream* out;
+  const file_contents* contents;
+};
+
+inline auto splice_file_contents(ostream& out, const file_contents& fc) noexcept
+    -> ostream_file_contents {
+  return {&out, &fc};
+}
+}  // namespace detail
+
+template <> struct formatter<file_contents> {
+  FMT_CONSTEXPR auto parse(parse_context<>& ctx) -> const char* {
+    return ctx.begin();
+  }
+
+  auto format(const file_contents& fc, format_context& ctx) const
+      -> format_context::iterator {
+    detail::write_file_contents(detail::get_container(ctx.out()), fc);
+    return ctx.out();
+  }
+};
+
+template <>
+struct formatter<detail::ostream_file_contents> : formatter<file_contents> {
+  auto format(const detail::ostream_file_contents& fc,
+              format_context& ctx) const -> format_context::iterator {
+    fc.out->write_file_contents(*fc.contents);
+    return ctx.out();
+  }
+};
+#  endif  // FMT_USE_MMAP
+
+/**
+ * A file opened for reading that transparently decompresses output written
+ * with `fmt::output_file(path, fmt::compress = fmt::compression::fast)`.
+ * Files without compression are read as is.
+ *
+ * **Example**:
+ *
+ *     auto in = fmt::input_file("trace.fmtz");
+ *     char buf[4096];
+ *     while (size_t n = in.read(buf, sizeof(buf))) fwrite(buf, 1, n, stdout);
+ */
+class FMT_API input_file {
+ private:
+  file file_;
+  bool compressed_ = false;
+  std::vector<char> block_;  // Decompressed data not yet read.
+  size_t pos_ = 0;
+  std::vector<char> stored_;
+
+  auto read_block() -> bool;
+
+ public:
+  explicit input_file(cstring_view path);
+
+  /// Reads up to `count` bytes of decompressed data into `buf` and returns
+  /// the number of bytes read or 0 at the end of the file.
+  auto read(void* buf, size_t count) -> size_t;
+};
+
+#  if FMT_USE_MMAP
+/**
+ * A log of the most recent records that survives a crash of the process.
+ * Records are formatted directly into fixed-size slots of a memory-mapped
+ * file used as a ring buffer, so writing a record doesn't make system calls.
+ * After a crash the records can be read with `read_flight_recorder`.
+ *
+ * Writing from multiple threads is safe as long as there are fewer
+ * concurrent writers than slots.
+ *
+ * **Example**:
+ *
+ *     auto rec = fmt::flight_recorder("app.rec", 1 << 20);
+ *     rec.print("request {} took {} ms", id, ms);
+ */
+class FMT_API flight_recorder {
+ private:
+  char* data_;  // The mapped file.
+  size_t size_;
+  size_t record_size_;
+  size_t num_slots_;
+
+ public:
+  /**
+   * Opens or creates a file of `size` bytes rounded up to the page size and
+   * maps it into memory. Records longer than `record_size` minus a 16-byte
+   * slot header are truncated. If the file already contains a recorder with
+   * the same geometry, new records are appended to it.
+   */
+  flight_recorder(cstring_view path, size_t size, size_t record_size = 256);
+  flight_recorder(flight_recorder&& other) noexcept;
+  ~flight_recorder();
+
+  flight_recorder(const flight_recorder&) = delete;
+  void operator=(const flight_recorder&) = delete;
+
+  /// Returns the maximum number of records kept.
+  auto capacity() const noexcept -> size_t { return num_slots_; }
+
+  void vprint(string_view fmt, format_args args);
+
+  /// Formats `args` according to specifications in `fmt` and stores the
+  /// output as a record replacing the oldest one if the recorder is full.
+  template <typename... T> void print(format_string<T...> fmt, T&&... args) {
+    vprint(fmt.str, vargs<T...>{{args...}});
+  }
+};
+
+/// Returns the complete records stored in a flight recorder file, oldest
+/// first.
+FMT_API auto read_flight_recorder(cstring_view path)
+    -> std::vector<std::string>;
+#  endif  // FMT_USE_MMAP
 #endif  // FMT_USE_FCNTL
 
 FMT_END_EXPORT
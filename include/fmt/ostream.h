@@ -9,7 +9,8 @@
 #define FMT_OSTREAM_H_
 
 #ifndef FMT_MODULE
-#  include <fstream>  // std::filebuf
+#  include <exception>  // std::rethrow_exception
+#  include <fstream>    // std::filebuf
 #endif
 
 #ifdef _WIN32
@@ -65,6 +66,68 @@ void write_buffer(std::basic_ostream<Char>& os, buffer<Char>& buf) {
   } while (size != 0);
 }
 
+// Exposes the protected put area interface of std::basic_streambuf.
+template <typename Char> struct streambuf_access : std::basic_streambuf<Char> {
+  using std::basic_streambuf<Char>::pptr;
+  using std::basic_streambuf<Char>::epptr;
+  using std::basic_streambuf<Char>::pbump;
+};
+
+// A buffer that formats directly into the free part of the put area of a
+// stream buffer and switches to a memory buffer if the output doesn't fit.
+// Nothing is handed over to the stream buffer until flush, so the output of
+// a formatting call that fails is discarded as a whole.
+template <typename Char> class streambuf_buffer : public buffer<Char> {
+ private:
+  using streambuf_type = std::basic_streambuf<Char>;
+  using access = streambuf_access<Char>;
+
+  streambuf_type& sb_;
+  basic_memory_buffer<Char> stash_;
+  bool stashed_ = false;
+
+  static void grow(buffer<Char>& buf, size_t capacity) {
+    auto& self = static_cast<streambuf_buffer&>(buf);
+    size_t size = buf.size();
+    if (self.stashed_) {
+      self.stash_.try_resize(size);
+    } else {
+      self.stash_.append(buf.data(), buf.data() + size);
+      self.stashed_ = true;
+    }
+    self.stash_.try_reserve(capacity);
+    self.set(self.stash_.data(), self.stash_.capacity());
+  }
+
+ public:
+  explicit streambuf_buffer(streambuf_type& sb) : buffer<Char>(grow), sb_(sb) {
+    Char* begin = (sb_.*&access::pptr)();
+    size_t n = begin ? to_unsigned((sb_.*&access::epptr)() - begin) : 0;
+    // pbump takes an int so limit the size of the put area used.
+    n = min_of<size_t>(n, to_unsigned(max_value<int>()));
+    if (n != 0) {
+      this->set(begin, n);
+    } else {
+      stashed_ = true;
+      this->set(stash_.data(), stash_.capacity());
+    }
+  }
+
+  // Hands over the output to the stream buffer and returns false if it
+  // failed to consume some of it.
+  auto flush() -> bool {
+    auto size = this->size();
+    this->clear();
+    if (size == 0) return true;
+    if (!stashed_) {
+      (sb_.*&access::pbump)(static_cast<int>(size));
+      return true;
+    }
+    auto n = static_cast<std::streamsize>(size);
+    return sb_.sputn(this->data(), n) == n;
+  }
+};
+
 template <typename T> struct streamed_view {
   const T& value;
 };
@@ -113,21 +176,53 @@ constexpr auto streamed(const T& value) -> detail::streamed_view<T> {
   return {value};
 }
 
-inline void vprint(std::ostream& os, string_view fmt, format_args args) {
+namespace detail {
+// Formats directly into the stream buffer of `os` without an intermediate
+// memory buffer if the output fits into the free part of the put area. If
+// formatting fails, e.g. with format_error, nothing is written and the
+// stream state is unchanged. If the stream buffer fails, badbit is set and
+// the exception is rethrown only if badbit is in exceptions() as in
+// ostream::write.
+template <typename Char>
+void vprint_directly(std::basic_ostream<Char>& os, basic_string_view<Char> fmt,
+                     basic_format_args<buffered_context<Char>> args,
+                     bool newline) {
+  typename std::basic_ostream<Char>::sentry sentry(os);
+  if (!sentry) return;
+  auto buf = streambuf_buffer<Char>(*os.rdbuf());
+  // Unqualified to find the wide overload from xchar.h via ADL.
+  vformat_to(buf, fmt, args);
+  if (newline) buf.push_back(Char('\n'));
+  FMT_TRY {
+    if (!buf.flush()) os.setstate(std::ios_base::badbit);
+  }
+  FMT_CATCH(...) {
+    bool rethrow = (os.exceptions() & std::ios_base::badbit) != 0;
+    // Set badbit without throwing ios_base::failure instead of the original
+    // exception.
+    FMT_TRY { os.setstate(std::ios_base::badbit); }
+    FMT_CATCH(...) {}
+    if (rethrow) std::rethrow_exception(std::current_exception());
+  }
+}
+
+inline void vprint(std::ostream& os, string_view fmt, format_args args,
+                   bool newline) {
+#ifdef _WIN32
   auto buffer = memory_buffer();
   detail::vformat_to(buffer, fmt, args);
+  if (newline) buffer.push_back('\n');
   FILE* f = nullptr;
-#if FMT_MSVC_STL_UPDATE && FMT_USE_RTTI
+#  if FMT_MSVC_STL_UPDATE && FMT_USE_RTTI
   if (auto* buf = dynamic_cast<std::filebuf*>(os.rdbuf()))
     f = detail::get_file(*buf);
-#elif defined(_WIN32) && defined(__GLIBCXX__) && FMT_USE_RTTI
+#  elif defined(__GLIBCXX__) && FMT_USE_RTTI
   auto* rdbuf = os.rdbuf();
   if (auto* sfbuf = dynamic_cast<__gnu_cxx::stdio_sync_filebuf<char>*>(rdbuf))
     f = sfbuf->file();
   else if (auto* fbuf = dynamic_cast<__gnu_cxx::stdio_filebuf<char>*>(rdbuf))
     f = fbuf->file();
-#endif
-#ifdef _WIN32
+#  endif
   if (f) {
     int fd = _fileno(f);
     if (_isatty(fd)) {
@@ -135,9 +230,15 @@ inline void vprint(std::ostream& os, string_view fmt, format_args args) {
       if (detail::write_console(fd, {buffer.data(), buffer.size()})) return;
     }
   }
-#endif
-  detail::ignore_unused(f);
   detail::write_buffer(os, buffer);
+#else
+  vprint_directly(os, fmt, args, newline);
+#endif
+}
+}  // namespace detail
+
+inline void vprint(std::ostream& os, string_view fmt, format_args args) {
+  detail::vprint(os, fmt, args, false);
 }
 
 /**
@@ -150,16 +251,17 @@ inline void vprint(std::ostream& os, string_view fmt, format_args args) {
 FMT_EXPORT template <typename... T>
 void print(std::ostream& os, format_string<T...> fmt, T&&... args) {
   fmt::vargs<T...> vargs = {{args...}};
-  if (detail::const_check(detail::use_utf8)) return vprint(os, fmt.str, vargs);
-  auto buffer = memory_buffer();
-  detail::vformat_to(buffer, fmt.str, vargs);
-  detail::write_buffer(os, buffer);
+  if (detail::const_check(detail::use_utf8))
+    return detail::vprint(os, fmt.str, vargs, false);
+  detail::vprint_directly(os, fmt.str, vargs, false);
 }
 
 FMT_EXPORT template <typename... T>
 void println(std::ostream& os, format_string<T...> fmt, T&&... args) {
-  fmt::print(os, FMT_STRING("{}\n"),
-             fmt::format(fmt, std::forward<T>(args)...));
+  fmt::vargs<T...> vargs = {{args...}};
+  if (detail::const_check(detail::use_utf8))
+    return detail::vprint(os, fmt.str, vargs, true);
+  detail::vprint_directly(os, fmt.str, vargs, true);
 }
 
 FMT_END_NAMESPACE
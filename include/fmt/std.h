@@ -81,30 +81,33 @@ namespace detail {
 
 #if FMT_CPP_LIB_FILESYSTEM
 
-template <typename Char, typename PathChar>
-auto get_path_string(const std::filesystem::path& p,
-                     const std::basic_string<PathChar>& native) {
-  if constexpr (std::is_same_v<Char, char> && std::is_same_v<PathChar, wchar_t>)
-    return to_utf8<wchar_t>(native, to_utf8_error_policy::replace);
-  else
-    return p.string<Char>();
-}
-
-template <typename Char, typename PathChar>
-void write_escaped_path(basic_memory_buffer<Char>& quoted,
-                        const std::filesystem::path& p,
-                        const std::basic_string<PathChar>& native) {
-  if constexpr (std::is_same_v<Char, char> &&
-                std::is_same_v<PathChar, wchar_t>) {
-    auto buf = basic_memory_buffer<wchar_t>();
-    write_escaped_string<wchar_t>(std::back_inserter(buf), native);
-    bool valid = to_utf8<wchar_t>::convert(quoted, {buf.data(), buf.size()});
-    FMT_ASSERT(valid, "invalid utf16");
-  } else if constexpr (std::is_same_v<Char, PathChar>) {
-    write_escaped_string<std::filesystem::path::value_type>(
-        std::back_inserter(quoted), native);
+// Writes a path string avoiding intermediate copies when the output and path
+// character types match. Escaping, if requested, is done in the same pass.
+template <typename Char, typename PathChar, typename OutputIt>
+auto write_path(OutputIt out, const std::filesystem::path& p,
+                basic_string_view<PathChar> native, format_specs specs,
+                bool debug) -> OutputIt {
+  if constexpr (std::is_same_v<Char, PathChar>) {
+    if (debug) specs.set_type(presentation_type::debug);
+    return write<Char>(out, native, specs);
+  } else if constexpr (std::is_same_v<Char, char> &&
+                       std::is_same_v<PathChar, wchar_t>) {
+    auto buf = memory_buffer();
+    if (debug) {
+      // Escape before transcoding to preserve invalid surrogates.
+      auto escaped = basic_memory_buffer<wchar_t>();
+      write_escaped_string<wchar_t>(basic_appender<wchar_t>(escaped), native);
+      bool valid =
+          to_utf8<wchar_t>::convert(buf, {escaped.data(), escaped.size()});
+      FMT_ASSERT(valid, "invalid utf16");
+    } else {
+      to_utf8<wchar_t>::convert(buf, native, to_utf8_error_policy::replace);
+    }
+    return write<Char>(out, string_view(buf.data(), buf.size()), specs);
   } else {
-    write_escaped_string<Char>(std::back_inserter(quoted), p.string<Char>());
+    auto s = p.string<Char>();
+    if (debug) specs.set_type(presentation_type::debug);
+    return write<Char>(out, basic_string_view<Char>(s), specs);
   }
 }
 
@@ -197,8 +200,7 @@ auto normalize_msvc_abi_name(string_view abi_name_view, OutputIt out)
   return out;
 }
 
-template <typename OutputIt>
-auto write_demangled_name(OutputIt out, const std::type_info& ti) -> OutputIt {
+inline auto demangle(const std::type_info& ti) -> std::string {
 #  ifdef FMT_HAS_ABI_CXA_DEMANGLE
   int status = 0;
   size_t size = 0;
@@ -212,9 +214,7 @@ auto write_demangled_name(OutputIt out, const std::type_info& ti) -> OutputIt {
   } else {
     demangled_name_view = string_view(ti.name());
   }
-  return detail::write_bytes<char>(out, demangled_name_view);
-#  elif FMT_MSC_VERSION && defined(_MSVC_STL_UPDATE)
-  return normalize_msvc_abi_name(ti.name(), out);
+  return {demangled_name_view.data(), demangled_name_view.size()};
 #  elif FMT_MSC_VERSION && defined(_LIBCPP_VERSION)
   const string_view demangled_name = ti.name();
   std::string name_copy(demangled_name.size(), '\0');
@@ -225,11 +225,100 @@ auto write_demangled_name(OutputIt out, const std::type_info& ti) -> OutputIt {
   // normalize_libcxx_inline_namespaces removes the inline __1, __2, etc
   // namespaces libc++ uses for ABI versioning On MSVC ABI + libc++
   // environments, we need to eliminate both of them.
-  const string_view normalized_name =
-      normalize_libcxx_inline_namespaces(name_copy, name_copy.data());
-  return detail::write_bytes<char>(out, normalized_name);
+  name_copy.resize(
+      normalize_libcxx_inline_namespaces(name_copy, name_copy.data()).size());
+  return name_copy;
 #  else
-  return detail::write_bytes<char>(out, string_view(ti.name()));
+  return ti.name();
+#  endif
+}
+
+// A process-wide lock-free cache of normalized demangled type names keyed by
+// the address of the mangled name. Entries are inserted with a CAS into an
+// open-addressing table and never removed, so lookups don't need any
+// synchronization other than acquire loads. Entries also keep a copy of the
+// mangled name, so that a different name at a reused address, e.g. after
+// dlclose, is not matched. Once a probe sequence is full no more entries are
+// added.
+class type_name_cache {
+ private:
+  struct entry {
+    const char* key;
+    std::string mangled_name;
+    std::string name;
+
+    auto matches(const char* k) const -> bool {
+      return key == k && std::strcmp(mangled_name.c_str(), k) == 0;
+    }
+  };
+
+  enum { num_slots = 512, max_probes = 16 };
+  std::atomic<entry*> slots_[num_slots];
+  std::atomic<bool> full_;
+
+  static auto hash(const char* key) -> size_t {
+    auto h = static_cast<uint64_t>(std::hash<const void*>()(key) >> 3);
+    return static_cast<size_t>((h * 0x9e3779b97f4a7c15) >> 32);
+  }
+
+ public:
+  type_name_cache() : slots_(), full_(false) {}
+
+  static auto instance() -> type_name_cache& {
+    static type_name_cache cache;
+    return cache;
+  }
+
+  // Returns the cached name or null if there is none.
+  auto find(const char* key) const -> const std::string* {
+    for (size_t i = 0, h = hash(key); i < max_probes; ++i) {
+      const entry* e =
+          slots_[(h + i) % num_slots].load(std::memory_order_acquire);
+      if (!e) return nullptr;
+      if (e->matches(key)) return &e->name;
+    }
+    return nullptr;
+  }
+
+  // Inserts a name and returns the cached copy or null if the cache is full.
+  // `name` is moved from only if the insertion succeeds.
+  auto insert(const char* key, std::string& name) -> const std::string* {
+    if (full_.load(std::memory_order_relaxed)) return nullptr;
+    auto e = std::unique_ptr<entry>();
+    for (size_t i = 0, h = hash(key); i < max_probes; ++i) {
+      auto& slot = slots_[(h + i) % num_slots];
+      entry* expected = slot.load(std::memory_order_acquire);
+      if (!expected) {
+        if (!e) e.reset(new entry{key, key, std::move(name)});
+        if (slot.compare_exchange_strong(expected, e.get(),
+                                         std::memory_order_acq_rel)) {
+          return &e.release()->name;
+        }
+      }
+      // Another thread may have inserted the same name concurrently.
+      if (expected->matches(key)) return &expected->name;
+    }
+    full_.store(true, std::memory_order_relaxed);
+    if (e) name = std::move(e->name);
+    return nullptr;
+  }
+};
+
+template <typename OutputIt>
+auto write_demangled_name(OutputIt out, const std::type_info& ti) -> OutputIt {
+#  if !defined(FMT_HAS_ABI_CXA_DEMANGLE) && FMT_MSC_VERSION && \
+      defined(_MSVC_STL_UPDATE)
+  return normalize_msvc_abi_name(ti.name(), out);
+#  else
+  auto& cache = type_name_cache::instance();
+  const char* key = ti.name();
+  const std::string* name = cache.find(key);
+  if (!name) {
+    auto demangled = demangle(ti);
+    name = cache.insert(key, demangled);
+    if (!name) return detail::write_bytes<char>(out, string_view(demangled));
+  }
+  return detail::write_bytes<char>(out, string_view(*name));
 #  endif
 }
 
@@ -257,6 +346,51 @@ struct is_bit_reference_like<std::__bit_const_reference<C>> {
 };
 #endif
 
+// Converts 8 bits to binary digits, most significant first, by spreading them
+// into the bytes of a 64-bit word. Requires a little-endian host.
+inline auto spread_binary_digits(unsigned byte) -> uint64_t {
+  uint64_t spread = (byte * 0x0101010101010101ull) & 0x0102040810204080ull;
+  // Map the nonzero bytes to 1 without carries between bytes.
+  spread = ((spread + 0x7f7f7f7f7f7f7f7full) >> 7) & 0x0101010101010101ull;
+  return spread + 0x3030303030303030ull;  // Add '0' to every byte.
+}
+
+// Writes the binary digits of the low `n` bits of `bits`, most significant
+// first.
+template <typename Char>
+void write_binary_digits(Char* out, uint64_t bits, int n) {
+  for (; n % 8 != 0; --n)
+    *out++ = static_cast<Char>('0' + ((bits >> (n - 1)) & 1));
+  if (std::is_same<Char, char>::value && !const_check(is_big_endian())) {
+    for (; n > 0; n -= 8, out += 8) {
+      uint64_t digits = spread_binary_digits((bits >> (n - 8)) & 0xff);
+      std::memcpy(out, &digits, 8);
+    }
+    return;
+  }
+  for (; n > 0; --n) *out++ = static_cast<Char>('0' + ((bits >> (n - 1)) & 1));
+}
+
+// Writes `num_bits` binary digits, most significant first, where `word(i)`
+// returns bits [64 * i, 64 * i + 64).
+template <typename Char, typename OutputIt, typename GetWord>
+auto write_binary_words(OutputIt out, size_t num_bits, GetWord word)
+    -> OutputIt {
+  if (num_bits == 0) return out;
+  size_t i = (num_bits + 63) / 64;
+  int n = num_bits % 64 != 0 ? static_cast<int>(num_bits % 64) : 64;
+  if (Char* ptr = to_pointer<Char>(out, num_bits)) {
+    for (; i > 0; ptr += n, n = 64) write_binary_digits(ptr, word(--i), n);
+    return out;
+  }
+  Char buf[64];
+  for (; i > 0; n = 64) {
+    write_binary_digits(buf, word(--i), n);
+    out = copy<Char>(buf, buf + n, out);
+  }
+  return out;
+}
+
 template <typename T, typename Enable = void>
 struct has_format_as : std::false_type {};
 template <typename T>
@@ -312,22 +446,19 @@ template <typename Char> struct formatter<std::filesystem::path, Char> {
 
   template <typename FormatContext>
   auto format(const std::filesystem::path& p, FormatContext& ctx) const {
+    using path_char = std::filesystem::path::value_type;
     auto specs = specs_;
-    auto path_string =
-        !path_type_ ? p.native()
-                    : p.generic_string<std::filesystem::path::value_type>();
-
     detail::handle_dynamic_spec(specs.dynamic_width(), specs.width, width_ref_,
                                 ctx);
-    if (!debug_) {
-      auto s = detail::get_path_string<Char>(p, path_string);
-      return detail::write(ctx.out(), basic_string_view<Char>(s), specs);
+    if (!path_type_) {
+      return detail::write_path<Char>(
+          ctx.out(), p, basic_string_view<path_char>(p.native()), specs,
+          debug_);
     }
-    auto quoted = basic_memory_buffer<Char>();
-    detail::write_escaped_path(quoted, p, path_string);
-    return detail::write(ctx.out(),
-                         basic_string_view<Char>(quoted.data(), quoted.size()),
-                         specs);
+    auto generic = p.generic_string<path_char>();
+    return detail::write_path<Char>(ctx.out(), p,
+                                    basic_string_view<path_char>(generic),
+                                    specs, debug_);
   }
 };
 
@@ -352,15 +483,46 @@ template <size_t N, typename Char>
 struct formatter<std::bitset<N>, Char>
     : nested_formatter<basic_string_view<Char>, Char> {
  private:
+  // std::bitset only gives access to the low 64 bits and to single bits.
+  // Shifting a copy extracts a word at a time but each shift is O(N), so
+  // words of bitsets up to bulk_bits are extracted in bulk and those of
+  // larger ones are gathered bit by bit which is linear.
+  static constexpr size_t bulk_bits = 2048;
+  static constexpr size_t num_bulk_words =
+      N <= bulk_bits && N != 0 ? (N + 63) / 64 : 1;
+
+  // Returns the i-th 64-bit word of a bitset.
+  struct get_word {
+    const std::bitset<N>& bs;
+    const uint64_t* words;  // Words extracted in bulk or null.
+
+    auto operator()(size_t i) const -> uint64_t {
+      if (words) return words[i];
+      uint64_t word = 0;
+      size_t end = (i + 1) * 64 < N ? (i + 1) * 64 : N;
+      for (size_t pos = end; pos > i * 64; --pos)
+        word = (word << 1) | (bs[pos - 1] ? 1u : 0u);
+      return word;
+    }
+  };
+
   // This is a functor because C++11 doesn't support generic lambdas.
   struct writer {
     const std::bitset<N>& bs;
 
-    template <typename OutputIt>
-    FMT_CONSTEXPR auto operator()(OutputIt out) -> OutputIt {
-      for (auto pos = N; pos > 0; --pos)
-        out = detail::write<Char>(out, bs[pos - 1] ? Char('1') : Char('0'));
-      return out;
+    template <typename OutputIt> auto operator()(OutputIt out) -> OutputIt {
+      uint64_t words[num_bulk_words];
+      bool bulk = N <= bulk_bits;
+      if (bulk) {
+        auto rest = bs;
+        const auto mask = std::bitset<N>(~0ull);
+        for (size_t i = 0; i < num_bulk_words; ++i) {
+          words[i] = static_cast<uint64_t>((rest & mask).to_ullong());
+          rest >>= 64;
+        }
+      }
+      return detail::write_binary_words<Char>(
+          out, N, get_word{bs, bulk ? words : nullptr});
     }
   };
 
@@ -372,6 +534,70 @@ struct formatter<std::bitset<N>, Char>
   }
 };
 
+/// A view of a bitmap stored in 64-bit words, see `fmt::bits`.
+struct bits_view {
+  const uint64_t* data;
+  size_t size;
+};
+
+/**
+ * Returns a view that formats `size` 64-bit words as binary digits. Bit `i`
+ * of the bitmap is bit `i % 64` of `data[i / 64]` and, like `std::bitset`,
+ * the bitmap is printed from the most significant bit to bit 0.
+ *
+ * **Example**:
+ *
+ *     uint64_t words[] = {5, 1};
+ *     fmt::print("{:>130}", fmt::bits(words, 2));
+ *     // Output: "  0...010...0101" (128 digits)
+ */
+inline auto bits(const uint64_t* data, size_t size) -> bits_view {
+  return {data, size};
+}
+
+/// Returns a view that formats a contiguous range of 64-bit words, such as
+/// `std::vector<uint64_t>` or `std::span<const uint64_t>`, as binary digits.
+template <typename Range,
+          FMT_ENABLE_IF(std::is_convertible<
+                        decltype(std::declval<const Range&>().data()),
+                        const uint64_t*>::value)>
+auto bits(const Range& r) -> bits_view {
+  return {r.data(), static_cast<size_t>(r.size())};
+}
+
+template <typename Char> struct formatter<bits_view, Char> {
+ private:
+  format_specs specs_;
+  detail::arg_ref<Char> width_ref_;
+
+ public:
+  FMT_CONSTEXPR auto parse(parse_context<Char>& ctx) -> const Char* {
+    auto it = ctx.begin(), end = ctx.end();
+    if (it == end) return it;
+    it = detail::parse_align(it, end, specs_);
+    if (it == end) return it;
+    Char c = *it;
+    if ((c >= '0' && c <= '9') || c == '{')
+      it = detail::parse_width(it, end, specs_, width_ref_, ctx);
+    return it;
+  }
+
+  template <typename FormatContext>
+  auto format(bits_view view, FormatContext& ctx) const
+      -> decltype(ctx.out()) {
+    auto specs = specs_;
+    detail::handle_dynamic_spec(specs.dynamic_width(), specs.width, width_ref_,
+                                ctx);
+    using iterator = detail::reserve_iterator<decltype(ctx.out())>;
+    size_t num_bits = view.size * 64;
+    return detail::write_padded<Char>(
+        ctx.out(), specs, num_bits, [=](iterator it) {
+          return detail::write_binary_words<Char>(
+              it, num_bits, [=](size_t i) { return view.data[i]; });
+        });
+  }
+};
+
 template <typename Char>
 struct formatter<std::thread::id, Char> : basic_ostream_formatter<Char> {};
 
@@ -689,7 +915,6 @@ template <typename T, typename Char> struct formatter<std::complex<T>, Char> {
     }
 
     if (specs.width == 0) return do_format(c, specs, ctx, ctx.out());
-    auto buf = basic_memory_buffer<Char>();
 
     auto outer_specs = format_specs();
     outer_specs.width = specs.width;
@@ -700,10 +925,10 @@ template <typename T, typename Char> struct formatter<std::complex<T>, Char> {
     specs.set_fill({});
     specs.set_align(align::none);
 
-    do_format(c, specs, ctx, basic_appender<Char>(buf));
-    return detail::write<Char>(ctx.out(),
-                               basic_string_view<Char>(buf.data(), buf.size()),
-                               outer_specs);
+    return detail::write_padded_output<Char>(
+        ctx.out(), outer_specs, [&](basic_appender<Char> out) {
+          return do_format(c, specs, ctx, out);
+        });
   }
 };
 
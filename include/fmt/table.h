@@ -0,0 +1,175 @@
+// Formatting library for C++ - aligned table output
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+
+#ifndef FMT_TABLE_H_
+#define FMT_TABLE_H_
+
+#ifndef FMT_MODULE
+#  include <string>
+#  include <vector>
+#endif
+
+#include "format.h"
+
+FMT_BEGIN_NAMESPACE
+namespace detail {
+
+struct table_cell {
+  size_t begin;  // Offset of the cell text in the arena.
+  size_t size;   // Size of the cell text in code units.
+  size_t width;  // Display width of the cell text.
+  bool numeric;
+};
+
+template <typename T>
+using is_numeric_cell =
+    bool_constant<(is_integral<T>::value || is_floating_point<T>::value) &&
+                  !std::is_same<T, bool>::value &&
+                  !std::is_same<T, char>::value>;
+
+}  // namespace detail
+
+/**
+ * A builder of aligned tables. Each cell is formatted once into an arena and
+ * its display width is recorded, so column widths are known without
+ * formatting the cells again. Formatting a table with `{}` emits the padded
+ * rows in a single pass.
+ *
+ * By default numeric cells are right-aligned and other cells are
+ * left-aligned. Use `set_align` to override the alignment of a column.
+ *
+ * To print a table that doesn't fit in memory, print it and call `clear` for
+ * each block of rows. Column widths are retained across blocks so the
+ * columns of later blocks are never narrower than the earlier ones. However,
+ * a wider cell in a later block widens its column, misaligning the block
+ * with the rows already printed. To keep streamed blocks aligned, fix the
+ * column widths up front with `set_min_width`.
+ *
+ * **Example**:
+ *
+ *     auto t = fmt::table();
+ *     t.add_row("name", "size");
+ *     t.add_row("a.txt", 42);
+ *     t.add_row("longer.txt", 1234);
+ *     fmt::print("{}", t);
+ *     // Output:
+ *     // name        size
+ *     // a.txt         42
+ *     // longer.txt  1234
+ */
+FMT_EXPORT class table {
+ private:
+  memory_buffer arena_;
+  std::vector<detail::table_cell> cells_;
+  std::vector<size_t> row_ends_;  // Indices of the cells ending each row.
+  std::vector<size_t> widths_;
+  std::vector<align> aligns_;
+  std::string separator_;
+
+  void end_cell(size_t begin, bool numeric) {
+    size_t size = arena_.size() - begin;
+    size_t width = detail::compute_display_width({arena_.data() + begin, size});
+    size_t column = cells_.size() - (row_ends_.empty() ? 0 : row_ends_.back());
+    if (column >= widths_.size()) widths_.resize(column + 1);
+    if (width > widths_[column]) widths_[column] = width;
+    cells_.push_back({begin, size, width, numeric});
+  }
+
+  template <typename T> void add_value(const T& value) {
+    size_t begin = arena_.size();
+    fmt::format_to(appender(arena_), "{}", value);
+    end_cell(begin, detail::is_numeric_cell<T>::value);
+  }
+
+  friend struct formatter<table>;
+
+ public:
+  /// Constructs a table with columns separated by `separator`.
+  explicit table(string_view separator = "  ")
+      : separator_(separator.data(), separator.size()) {}
+
+  /// Sets the alignment of the column with index `column`.
+  void set_align(size_t column, align a) {
+    if (column >= aligns_.size()) aligns_.resize(column + 1, align::none);
+    aligns_[column] = a;
+  }
+
+  /// Sets the minimum display width of the column with index `column`.
+  void set_min_width(size_t column, size_t width) {
+    if (column >= widths_.size()) widths_.resize(column + 1);
+    if (width > widths_[column]) widths_[column] = width;
+  }
+
+  /// Appends a cell formatted according to `fmt` to the current row.
+  template <typename... T>
+  void add_cell(format_string<T...> fmt, T&&... args) {
+    size_t begin = arena_.size();
+    fmt::vformat_to(appender(arena_), fmt.str, vargs<T...>{{args...}});
+    end_cell(begin, false);
+  }
+
+  /// Finishes the current row.
+  void end_row() { row_ends_.push_back(cells_.size()); }
+
+  /// Appends a row of cells formatted with `{}`.
+  template <typename... T> void add_row(const T&... cells) {
+    FMT_APPLY_VARIADIC(add_value(cells));
+    end_row();
+  }
+
+  /// Returns the number of complete rows.
+  auto num_rows() const -> size_t { return row_ends_.size(); }
+
+  /// Removes all rows keeping column widths and alignments.
+  void clear() {
+    arena_.clear();
+    cells_.clear();
+    row_ends_.clear();
+  }
+};
+
+template <> struct formatter<table> {
+  FMT_CONSTEXPR auto parse(parse_context<>& ctx) -> const char* {
+    return ctx.begin();
+  }
+
+  template <typename FormatContext>
+  auto format(const table& t, FormatContext& ctx) const
+      -> decltype(ctx.out()) {
+    auto out = ctx.out();
+    const char* text = t.arena_.data();
+    size_t cell_index = 0;
+    for (size_t row_end : t.row_ends_) {
+      for (size_t column = 0; cell_index < row_end; ++column, ++cell_index) {
+        const detail::table_cell& cell = t.cells_[cell_index];
+        if (column != 0) {
+          out = detail::copy<char>(t.separator_.data(),
+                                   t.separator_.data() + t.separator_.size(),
+                                   out);
+        }
+        auto a = column < t.aligns_.size() ? t.aligns_[column] : align::none;
+        if (a == align::none) a = cell.numeric ? align::right : align::left;
+        size_t padding = t.widths_[column] - cell.width;
+        size_t left = a == align::right    ? padding
+                      : a == align::center ? padding / 2
+                                           : 0;
+        // Don't emit trailing spaces after the last cell of a row.
+        size_t right = cell_index + 1 == row_end ? 0 : padding - left;
+        out = detail::fill_n(out, left, ' ');
+        out = detail::copy<char>(text + cell.begin,
+                                 text + cell.begin + cell.size, out);
+        out = detail::fill_n(out, right, ' ');
+      }
+      *out++ = '\n';
+    }
+    return out;
+  }
+};
+
+FMT_END_NAMESPACE
+
+#endif  // FMT_TABLE_H_
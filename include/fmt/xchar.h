@@ -331,9 +331,7 @@ inline auto format(text_style ts, wformat_string<T...> fmt, T&&... args)
 }
 
 inline void vprint(std::wostream& os, wstring_view fmt, wformat_args args) {
-  auto buffer = basic_memory_buffer<wchar_t>();
-  detail::vformat_to(buffer, fmt, args);
-  detail::write_buffer(os, buffer);
+  detail::vprint_directly(os, fmt, args, false);
 }
 
 template <typename... T>
@@ -12,10 +12,12 @@ module;
 // to prevent attachment to this module.
 #ifndef FMT_IMPORT_STD
 #  include <algorithm>
+#  include <atomic>
 #  include <bitset>
 #  include <chrono>
 #  include <cmath>
 #  include <complex>
+#  include <condition_variable>
 #  include <cstddef>
 #  include <cstdint>
 #  include <cstdio>
@@ -33,6 +35,7 @@ module;
 #  include <limits>
 #  include <locale>
 #  include <memory>
+#  include <mutex>
 #  include <optional>
 #  include <ostream>
 #  include <source_location>
@@ -64,6 +67,10 @@ module;
 #if defined(_MSC_VER) || defined(__MINGW32__)
 #  include <intrin.h>
 #endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <immintrin.h>
+#endif
 #if defined __APPLE__ || defined(__FreeBSD__)
 #  include <xlocale.h>
 #endif
@@ -77,7 +84,11 @@ module;
 #  include <sys/stat.h>
 #  include <sys/types.h>
 #  ifndef _WIN32
+#    include <sys/mman.h>
 #    include <unistd.h>
+#    ifdef __linux__
+#      include <sys/sendfile.h>
+#    endif
 #  else
 #    include <io.h>
 #  endif
@@ -117,6 +128,7 @@ extern "C++" {
 // All library-provided declarations and definitions must be in the module
 // purview to be exported.
 #include "fmt/args.h"
+#include "fmt/batch.h"
 #include "fmt/chrono.h"
 #include "fmt/color.h"
 #include "fmt/compile.h"
@@ -128,6 +140,7 @@ extern "C++" {
 #include "fmt/printf.h"
 #include "fmt/ranges.h"
 #include "fmt/std.h"
+#include "fmt/table.h"
 #include "fmt/xchar.h"
 
 #ifdef FMT_ATTACH_TO_GLOBAL_MODULE
@@ -30,6 +30,71 @@ template FMT_API auto decimal_point_impl(locale_ref) -> char;
 // DEPRECATED!
 template FMT_API void buffer<char>::append(const char*, const char*);
 
+// Hot writers and formatters declared with extern template in format.h.
+
+#if !FMT_REDUCE_INT_INSTANTIATIONS
+template FMT_API auto write_int_noinline<char>(appender,
+                                               write_int_arg<uint32_t>,
+                                               const format_specs&)
+    -> appender;
+#endif
+template FMT_API auto write_int(appender, uint64_t, unsigned,
+                                const format_specs&,
+                                const digit_grouping<char>&) -> appender;
+template FMT_API auto write_int(appender, uint128_t, unsigned,
+                                const format_specs&,
+                                const digit_grouping<char>&) -> appender;
+template FMT_API auto write_int_noinline<char>(appender,
+                                               write_int_arg<uint64_t>,
+                                               const format_specs&)
+    -> appender;
+template FMT_API auto write_int_noinline<char>(appender,
+                                               write_int_arg<uint128_t>,
+                                               const format_specs&)
+    -> appender;
+template FMT_API auto write<char>(appender, string_view, const format_specs&)
+    -> appender;
+template FMT_API auto write<char>(appender, float, format_specs, locale_ref)
+    -> appender;
+template FMT_API auto write<char>(appender, double, format_specs, locale_ref)
+    -> appender;
+template FMT_API auto write<char>(appender, long double, format_specs,
+                                  locale_ref) -> appender;
+template FMT_API auto write<char>(appender, float) -> appender;
+template FMT_API auto write<char>(appender, double) -> appender;
+
+template FMT_API auto native_formatter<int, char, type::int_type>::format(
+    const int&, format_context&) const -> appender;
+template FMT_API auto native_formatter<unsigned, char, type::uint_type>::format(
+    const unsigned&, format_context&) const -> appender;
+template FMT_API auto
+native_formatter<long long, char, type::long_long_type>::format(
+    const long long&, format_context&) const -> appender;
+template FMT_API auto
+native_formatter<unsigned long long, char, type::ulong_long_type>::format(
+    const unsigned long long&, format_context&) const -> appender;
+template FMT_API auto native_formatter<bool, char, type::bool_type>::format(
+    const bool&, format_context&) const -> appender;
+template FMT_API auto native_formatter<char, char, type::char_type>::format(
+    const char&, format_context&) const -> appender;
+template FMT_API auto native_formatter<float, char, type::float_type>::format(
+    const float&, format_context&) const -> appender;
+template FMT_API auto
+native_formatter<double, char, type::double_type>::format(
+    const double&, format_context&) const -> appender;
+template FMT_API auto
+native_formatter<long double, char, type::long_double_type>::format(
+    const long double&, format_context&) const -> appender;
+template FMT_API auto
+native_formatter<const char*, char, type::cstring_type>::format(
+    const char* const&, format_context&) const -> appender;
+template FMT_API auto
+native_formatter<string_view, char, type::string_type>::format(
+    const string_view&, format_context&) const -> appender;
+template FMT_API auto
+native_formatter<const void*, char, type::pointer_type>::format(
+    const void* const&, format_context&) const -> appender;
+
 // Explicit instantiations for wchar_t.
 
 template FMT_API auto thousands_sep_impl(locale_ref)
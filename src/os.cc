@@ -13,7 +13,9 @@
 #include "fmt/os.h"
 
 #ifndef FMT_MODULE
+#  include <algorithm>
 #  include <climits>
+#  include <memory>
 
 #  if FMT_USE_FCNTL
 #    include <sys/stat.h>
@@ -33,6 +35,15 @@
 #    endif  // _WIN32
 #  endif    // FMT_USE_FCNTL
 
+#  if FMT_USE_MMAP
+#    include <sys/mman.h>
+#    ifdef __linux__
+#      include <sys/sendfile.h>
+#    endif
+
+#    include <atomic>
+#  endif
+
 #  ifdef _WIN32
 #    include <windows.h>
 #  endif
@@ -282,6 +293,14 @@ auto file::write(const void* buffer, size_t count) -> size_t {
   return detail::to_unsigned(result);
 }
 
+auto file::try_write(const void* buffer, size_t count) -> size_t {
+  rwresult result = 0;
+  FMT_RETRY(result, FMT_POSIX_CALL(write(fd_, buffer, convert_rwcount(count))));
+  if (result >= 0) return detail::to_unsigned(result);
+  if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+  FMT_THROW(system_error(errno, FMT_STRING("cannot write to file")));
+}
+
 auto file::dup(int fd) -> file {
   // Don't retry as dup doesn't return EINTR.
   // http://pubs.opengroup.org/onlinepubs/009695399/functions/dup.html
@@ -374,25 +393,600 @@ auto getpagesize() -> long {
 }
 #  endif
 
+namespace {
+// A compressed file starts with a signature followed by blocks. A block
+// consists of an 8-byte header with the little-endian sizes of decompressed
+// and stored data followed by the stored data. The data is stored without
+// compression if the sizes are equal.
+//
+// Compressed data is a sequence of LZ77 commands each consisting of a token
+// byte with the number of literals in the high and the match length minus
+// min_match in the low 4 bits, the literals, a 2-byte little-endian match
+// offset and the match length. Lengths that don't fit into 4 bits are
+// continued in the following bytes, each adding its value, until a byte
+// other than 255. The last command has no match.
+constexpr char compressed_magic[8] = {'\x89', 'F',  'M',  'T',
+                                      'Z',    '\r', '\n', '\x1a'};
+constexpr size_t block_header_size = 8;
+constexpr size_t max_block_size = size_t(1) << 24;
+constexpr size_t min_match = 4;
+constexpr size_t max_offset = 0xffff;
+
+void write_u32(char* p, uint32_t value) {
+  for (int i = 0; i < 4; ++i) p[i] = static_cast<char>(value >> (i * 8));
+}
+
+auto read_u32(const char* p) -> uint32_t {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i)
+    value |= uint32_t(static_cast<unsigned char>(p[i])) << (i * 8);
+  return value;
+}
+
+auto load32(const char* p) -> uint32_t {
+  uint32_t value = 0;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+auto write_length(char* out, size_t n) -> char* {
+  if (n < 15) return out;
+  for (n -= 15; n >= 255; n -= 255) *out++ = '\xff';
+  *out++ = static_cast<char>(n);
+  return out;
+}
+
+auto read_length(const char*& in, const char* end, size_t& n) -> bool {
+  if (n != 15) return true;
+  for (;;) {
+    if (in == end) return false;
+    auto c = static_cast<unsigned char>(*in++);
+    n += c;
+    if (c != 255) return true;
+  }
+}
+
+// Writes a command with `num_literals` literals and a match of `match_len`
+// bytes (0 for the last command) if it fits in [out, out_end).
+auto write_command(char*& out, const char* out_end, const char* literals,
+                   size_t num_literals, size_t offset, size_t match_len)
+    -> bool {
+  size_t len = match_len != 0 ? match_len - min_match : 0;
+  auto length_size = [](size_t n) { return n < 15 ? 0 : (n - 15) / 255 + 1; };
+  size_t size = 1 + length_size(num_literals) + num_literals;
+  if (match_len != 0) size += 2 + length_size(len);
+  if (size > detail::to_unsigned(out_end - out)) return false;
+  *out++ = static_cast<char>(min_of<size_t>(num_literals, 15) << 4 |
+                             min_of<size_t>(len, 15));
+  out = write_length(out, num_literals);
+  if (num_literals != 0) std::memcpy(out, literals, num_literals);
+  out += num_literals;
+  if (match_len == 0) return true;
+  *out++ = static_cast<char>(offset & 0xff);
+  *out++ = static_cast<char>(offset >> 8);
+  out = write_length(out, len);
+  return true;
+}
+
+// Decompresses [in, in + size) into [out, out + out_size) returning false
+// if the data is invalid.
+auto decompress(const char* in, size_t size, char* out, size_t out_size)
+    -> bool {
+  const char* end = in + size;
+  char* p = out;
+  char* out_end = out + out_size;
+  for (;;) {
+    if (in == end) return false;
+    auto token = static_cast<unsigned char>(*in++);
+    size_t num_literals = token >> 4;
+    if (!read_length(in, end, num_literals) ||
+        num_literals > detail::to_unsigned(end - in) ||
+        num_literals > detail::to_unsigned(out_end - p)) {
+      return false;
+    }
+    if (num_literals != 0) std::memcpy(p, in, num_literals);
+    in += num_literals;
+    p += num_literals;
+    if (in == end) return p == out_end;
+    if (end - in < 2) return false;
+    size_t offset = static_cast<unsigned char>(in[0]) |
+                    size_t(static_cast<unsigned char>(in[1])) << 8;
+    in += 2;
+    size_t len = token & 15;
+    if (!read_length(in, end, len)) return false;
+    len += min_match;
+    if (offset == 0 || offset > detail::to_unsigned(p - out) ||
+        len > detail::to_unsigned(out_end - p)) {
+      return false;
+    }
+    const char* match = p - offset;
+    if (offset >= len) {
+      std::memcpy(p, match, len);
+      p += len;
+    } else {
+      // The match overlaps the output, e.g. a run of repeated characters.
+      for (const char* match_end = match + len; match != match_end; ++match)
+        *p++ = *match;
+    }
+  }
+}
+
+auto read_fully(file& f, char* buf, size_t count) -> size_t {
+  size_t n = 0;
+  while (n < count) {
+    size_t result = f.read(buf + n, count - n);
+    if (result == 0) break;
+    n += result;
+  }
+  return n;
+}
+
+FMT_NORETURN void report_invalid_compressed_file() {
+  FMT_THROW(std::runtime_error("invalid compressed file"));
+}
+}  // namespace
+
+namespace detail {
+class compressor {
+ private:
+  static constexpr int table_bits = 14;
+
+  // Positions of the last occurrences of 4-byte sequences by hash offset by
+  // `base_`, so that the entries from previous blocks are less than `base_`
+  // and the table doesn't need to be cleared for every block.
+  std::vector<uint32_t> table_ = std::vector<uint32_t>(size_t(1) << table_bits);
+  uint32_t base_ = 0;
+
+ public:
+  std::vector<char> block;  // The last block with a header.
+
+  // Compresses data into `block` storing it without compression if it
+  // doesn't compress.
+  void compress(const char* data, size_t size) {
+    block.resize(block_header_size + size);
+    write_u32(block.data(), static_cast<uint32_t>(size));
+    char* out = block.data() + block_header_size;
+    size_t stored_size = compress(data, size, out, out + size - 1);
+    if (stored_size == 0) {
+      std::memcpy(out, data, size);
+      stored_size = size;
+    }
+    write_u32(block.data() + 4, static_cast<uint32_t>(stored_size));
+    block.resize(block_header_size + stored_size);
+
+    if (base_ > UINT32_MAX - 2 * max_block_size) {
+      std::fill(table_.begin(), table_.end(), 0);
+      base_ = 0;
+    } else {
+      base_ += static_cast<uint32_t>(size);
+    }
+  }
+
+  // Returns the size of compressed data or 0 if it doesn't fit in
+  // [out, out_end).
+  auto compress(const char* in, size_t size, char* out, const char* out_end)
+      -> size_t {
+    if (size == 0) return 0;
+    const char* begin = out;
+    const char* end = in + size;
+    const char* literals = in;
+    const char* p = in;
+    size_t misses = 0;
+    for (; end - p >= static_cast<ptrdiff_t>(min_match);) {
+      uint32_t seq = load32(p);
+      uint32_t& entry = table_[(seq * 2654435761u) >> (32 - table_bits)];
+      auto pos = static_cast<uint32_t>(p - in);
+      uint32_t candidate = entry;
+      entry = base_ + pos;
+      if (candidate < base_ || candidate - base_ >= pos ||
+          pos - (candidate - base_) > max_offset ||
+          load32(in + (candidate - base_)) != seq) {
+        // Skip faster through data that doesn't compress.
+        p += 1 + (misses++ >> 6);
+        continue;
+      }
+      misses = 0;
+      const char* match = in + (candidate - base_);
+      while (p > literals && match > in && p[-1] == match[-1]) {
+        --p;
+        --match;
+      }
+      size_t len = min_match;
+      while (p + len != end && p[len] == match[len]) ++len;
+      if (!write_command(out, out_end, literals, to_unsigned(p - literals),
+                         to_unsigned(p - match), len)) {
+        return 0;
+      }
+      p += len;
+      literals = p;
+    }
+    if (!write_command(out, out_end, literals, to_unsigned(end - literals), 0,
+                       0)) {
+      return 0;
+    }
+    return to_unsigned(out - begin);
+  }
+};
+}  // namespace detail
+
 void ostream::grow(buffer<char>& buf, size_t) {
   if (buf.size() == buf.capacity()) static_cast<ostream&>(buf).flush();
 }
 
 ostream::ostream(cstring_view path, const detail::ostream_params& params)
-    : buffer<char>(grow), file_(path, params.oflag) {
+    : ostream(file(path, params.oflag), params) {}
+
+ostream::ostream(file f, const detail::ostream_params& params)
+    : buffer<char>(grow),
+      file_(std::move(f)),
+      nonblocking_(params.nonblocking) {
+  auto c = std::unique_ptr<detail::compressor>();
+  if (params.compress != compression::none) {
+    c.reset(new detail::compressor());
+    // Appending to a compressed file continues its sequence of blocks.
+    if ((params.oflag & file::APPEND) == 0 || file_.size() == 0)
+      write_data(compressed_magic, sizeof(compressed_magic));
+  }
   set(new char[params.buffer_size], params.buffer_size);
+  compressor_ = c.release();
 }
 
 ostream::ostream(ostream&& other) noexcept
     : buffer<char>(grow, other.data(), other.size(), other.capacity()),
-      file_(std::move(other.file_)) {
+      file_(std::move(other.file_)),
+      compressor_(other.compressor_),
+      nonblocking_(other.nonblocking_),
+      pending_(std::move(other.pending_)),
+      pending_begin_(other.pending_begin_) {
   other.clear();
   other.set(nullptr, 0);
+  other.compressor_ = nullptr;
+  other.pending_begin_ = 0;
 }
 
 ostream::~ostream() {
   flush();
   delete[] data();
+  delete compressor_;
+}
+
+void ostream::write_data(const char* data, size_t size) {
+  if (!nonblocking_) {
+    // A partially written block would make the rest of the file unreadable.
+    for (size_t n = 0; n < size;) n += file_.write(data + n, size - n);
+    return;
+  }
+  // Keep the order of output by not writing while older output is queued.
+  size_t n = want_write() ? 0 : file_.try_write(data, size);
+  pending_.insert(pending_.end(), data + n, data + size);
+}
+
+void ostream::write_buffer() {
+  if (!compressor_) return write_data(data(), size());
+  for (size_t offset = 0; offset < size(); offset += max_block_size) {
+    compressor_->compress(data() + offset,
+                          min_of(size() - offset, max_block_size));
+    const std::vector<char>& block = compressor_->block;
+    write_data(block.data(), block.size());
+  }
+}
+
+auto ostream::try_flush() -> bool {
+  size_t& n = pending_begin_;
+  while (n < pending_.size()) {
+    size_t result = file_.try_write(pending_.data() + n, pending_.size() - n);
+    if (result == 0) break;
+    n += result;
+  }
+  if (n == pending_.size()) {
+    pending_.clear();
+    n = 0;
+  } else if (n > pending_.size() / 2) {
+    // Compact rarely to avoid moving the queue after every partial write.
+    auto begin = pending_.begin();
+    pending_.erase(begin, begin + static_cast<ptrdiff_t>(n));
+    n = 0;
+  }
+  flush();
+  return !want_write();
+}
+
+input_file::input_file(cstring_view path) : file_(path, file::RDONLY) {
+  char magic[sizeof(compressed_magic)];
+  size_t n = read_fully(file_, magic, sizeof(magic));
+  compressed_ = n == sizeof(magic) &&
+                std::memcmp(magic, compressed_magic, sizeof(magic)) == 0;
+  if (!compressed_) block_.assign(magic, magic + n);
+}
+
+auto input_file::read_block() -> bool {
+  char header[block_header_size];
+  for (;;) {
+    size_t n = read_fully(file_, header, sizeof(header));
+    if (n == 0) return false;
+    if (n != sizeof(header)) report_invalid_compressed_file();
+    // Skip the signature of a concatenated file.
+    if (std::memcmp(header, compressed_magic, sizeof(header)) == 0) continue;
+    size_t size = read_u32(header), stored_size = read_u32(header + 4);
+    if (size > max_block_size || stored_size > size)
+      report_invalid_compressed_file();
+    stored_.resize(stored_size);
+    if (read_fully(file_, stored_.data(), stored_size) != stored_size)
+      report_invalid_compressed_file();
+    pos_ = 0;
+    if (stored_size == size) {
+      block_.swap(stored_);
+    } else {
+      block_.resize(size);
+      if (!decompress(stored_.data(), stored_size, block_.data(), size))
+        report_invalid_compressed_file();
+    }
+    if (size != 0) return true;
+  }
+}
+
+auto input_file::read(void* buf, size_t count) -> size_t {
+  if (pos_ == block_.size()) {
+    if (!compressed_) return file_.read(buf, count);
+    if (!read_block()) return 0;
+  }
+  size_t n = min_of(count, block_.size() - pos_);
+  std::memcpy(buf, block_.data() + pos_, n);
+  pos_ += n;
+  return n;
+}
+
+#  if FMT_USE_MMAP
+namespace {
+// A flight recorder file starts with a header followed by slots each
+// beginning with a slot header.
+struct recorder_header {
+  char magic[8];
+  uint64_t size;
+  uint64_t record_size;
+  std::atomic<uint64_t> cursor;  // The number of reserved records.
+};
+
+struct slot_header {
+  std::atomic<uint64_t> seq;  // The record index plus one or 0 if invalid.
+  uint64_t size;
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "atomic has unexpected size");
+
+constexpr char recorder_magic[8] = {'f', 'm', 't', 'r', 'e', 'c', '0', '1'};
+constexpr size_t recorder_header_size = 64;
+
+auto read_u64(const char* p) -> uint64_t {
+  uint64_t value = 0;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+}  // namespace
+
+flight_recorder::flight_recorder(cstring_view path, size_t size,
+                                 size_t record_size) {
+  record_size = (max_of(record_size, sizeof(slot_header) + 1) + 7) & ~size_t(7);
+  size = max_of(size, recorder_header_size + record_size);
+  auto page_size = detail::to_unsigned(getpagesize());
+  size = (size + page_size - 1) / page_size * page_size;
+  auto f = file(path, file::RDWR | file::CREATE);
+  bool same_size = detail::to_unsigned(f.size()) == size;
+  if (!same_size &&
+      ::ftruncate(f.descriptor(), static_cast<off_t>(size)) != 0) {
+    FMT_THROW(system_error(errno, FMT_STRING("cannot resize file {}"),
+                           path.c_str()));
+  }
+  void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   f.descriptor(), 0);
+  if (p == MAP_FAILED)
+    FMT_THROW(system_error(errno, FMT_STRING("cannot map file {}"),
+                           path.c_str()));
+  data_ = static_cast<char*>(p);
+  size_ = size;
+  record_size_ = record_size;
+  num_slots_ = (size - recorder_header_size) / record_size;
+
+  auto header = reinterpret_cast<recorder_header*>(data_);
+  if (same_size &&
+      std::memcmp(header->magic, recorder_magic, sizeof(recorder_magic)) ==
+          0 &&
+      header->size == size && header->record_size == record_size) {
+    return;
+  }
+  std::memset(data_, 0, size);
+  std::memcpy(header->magic, recorder_magic, sizeof(recorder_magic));
+  header->size = size;
+  header->record_size = record_size;
+}
+
+flight_recorder::flight_recorder(flight_recorder&& other) noexcept
+    : data_(other.data_),
+      size_(other.size_),
+      record_size_(other.record_size_),
+      num_slots_(other.num_slots_) {
+  other.data_ = nullptr;
+}
+
+flight_recorder::~flight_recorder() {
+  if (data_) ::munmap(data_, size_);
+}
+
+void flight_recorder::vprint(string_view fmt, format_args args) {
+  auto& cursor = reinterpret_cast<recorder_header*>(data_)->cursor;
+  uint64_t index = cursor.fetch_add(1, std::memory_order_relaxed);
+  char* slot = data_ + recorder_header_size +
+               static_cast<size_t>(index % num_slots_) * record_size_;
+  auto header = reinterpret_cast<slot_header*>(slot);
+  // Invalidate the slot before overwriting it so that a crash in the middle
+  // of formatting doesn't leave a record that looks complete.
+  header->seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  size_t capacity = record_size_ - sizeof(slot_header);
+  auto buf = detail::iterator_buffer<char*, char, detail::fixed_buffer_traits>(
+      slot + sizeof(slot_header), capacity);
+  detail::vformat_to(buf, fmt, args);
+  header->size = min_of(buf.count(), capacity);
+  header->seq.store(index + 1, std::memory_order_release);
+}
+
+auto read_flight_recorder(cstring_view path) -> std::vector<std::string> {
+  auto f = file(path, file::RDONLY);
+  auto data = std::vector<char>(detail::to_unsigned(f.size()));
+  for (size_t n = 0; n < data.size();) {
+    size_t count = f.read(data.data() + n, data.size() - n);
+    if (count == 0) break;
+    n += count;
+  }
+  auto is_valid = [&]() {
+    if (data.size() < recorder_header_size ||
+        std::memcmp(data.data(), recorder_magic, sizeof(recorder_magic)) != 0)
+      return false;
+    const char* header = data.data();
+    uint64_t record_size =
+        read_u64(header + offsetof(recorder_header, record_size));
+    return read_u64(header + offsetof(recorder_header, size)) == data.size() &&
+           record_size > sizeof(slot_header) &&
+           record_size <= data.size() - recorder_header_size;
+  };
+  if (!is_valid())
+    FMT_THROW(std::runtime_error("invalid flight recorder file"));
+  size_t record_size = static_cast<size_t>(
+      read_u64(data.data() + offsetof(recorder_header, record_size)));
+
+  struct record {
+    uint64_t seq;
+    const char* data;
+    size_t size;
+  };
+  auto records = std::vector<record>();
+  size_t num_slots = (data.size() - recorder_header_size) / record_size;
+  size_t capacity = record_size - sizeof(slot_header);
+  for (size_t i = 0; i < num_slots; ++i) {
+    const char* slot = data.data() + recorder_header_size + i * record_size;
+    uint64_t seq = read_u64(slot + offsetof(slot_header, seq));
+    uint64_t n = read_u64(slot + offsetof(slot_header, size));
+    // Skip empty slots, records being written and damaged slots.
+    if (seq == 0 || (seq - 1) % num_slots != i || n > capacity) continue;
+    records.push_back({seq, slot + sizeof(slot_header), size_t(n)});
+  }
+  std::sort(records.begin(), records.end(),
+            [](const record& a, const record& b) { return a.seq < b.seq; });
+  auto result = std::vector<std::string>();
+  result.reserve(records.size());
+  for (const record& r : records) result.emplace_back(r.data, r.size);
+  return result;
+}
+
+namespace {
+// Returns the size of the part of the range [offset, offset + size) within
+// the file.
+auto clamp_file_range(const file& f, long long offset, size_t size) -> size_t {
+  long long file_size = f.size();
+  if (offset < 0 || offset >= file_size) return 0;
+  auto available = detail::to_unsigned(file_size - offset);
+  return size < available ? size : static_cast<size_t>(available);
+}
+
+// Transfers up to `size` bytes at `offset` from `in` to `out` in the kernel
+// and returns the number of bytes transferred. It is less than `size` if
+// the transfer is not supported for these files.
+auto transfer_file_range(int in, long long offset, int out, size_t size)
+    -> size_t {
+  size_t n = 0;
+#    ifdef __linux__
+  auto is_unsupported = [](int error) {
+    return error == EINVAL || error == EXDEV || error == ENOSYS ||
+           error == EOPNOTSUPP || error == EBADF;
+  };
+#      if defined(__GLIBC__) && \
+          (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+  while (n < size) {
+    auto off = static_cast<loff_t>(offset) + static_cast<loff_t>(n);
+    ssize_t result = ::copy_file_range(in, &off, out, nullptr, size - n, 0);
+    if (result > 0) {
+      n += static_cast<size_t>(result);
+    } else if (result == 0) {
+      return n;
+    } else if (errno != EINTR) {
+      if (is_unsupported(errno)) break;
+      FMT_THROW(system_error(errno, FMT_STRING("cannot copy file range")));
+    }
+  }
+#      endif
+  while (n < size) {
+    auto off = static_cast<off_t>(offset) + static_cast<off_t>(n);
+    ssize_t result = ::sendfile(out, in, &off, size - n);
+    if (result > 0) {
+      n += static_cast<size_t>(result);
+    } else if (result == 0) {
+      return n;
+    } else if (errno != EINTR) {
+      if (is_unsupported(errno)) break;
+      FMT_THROW(system_error(errno, FMT_STRING("cannot copy file range")));
+    }
+  }
+#    else
+  detail::ignore_unused(in, offset, out);
+#    endif
+  return n;
+}
+}  // namespace
+
+void detail::write_file_contents(buffer<char>& buf, const file_contents& fc) {
+  const file& f = fc.get_file();
+  size_t size = clamp_file_range(f, fc.offset(), fc.size());
+  if (size == 0) return;
+  // Map whole pages and copy the requested part.
+  auto page_size = static_cast<long long>(getpagesize());
+  long long start = fc.offset() / page_size * page_size;
+  auto skip = static_cast<size_t>(fc.offset() - start);
+  void* p = ::mmap(nullptr, skip + size, PROT_READ, MAP_PRIVATE,
+                   f.descriptor(), static_cast<off_t>(start));
+  if (p != MAP_FAILED) {
+    struct mapping {
+      void* data;
+      size_t size;
+      ~mapping() { ::munmap(data, size); }
+    } m = {p, skip + size};
+    const char* data = static_cast<const char*>(m.data) + skip;
+    buf.append(data, data + size);
+    return;
+  }
+  // Some files such as those in /proc can't be mapped.
+  char chunk[4096];
+  for (long long offset = fc.offset(); size != 0;) {
+    ssize_t result = ::pread(f.descriptor(), chunk,
+                             min_of(size, sizeof(chunk)), offset);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      FMT_THROW(system_error(errno, FMT_STRING("cannot read from file")));
+    }
+    if (result == 0) break;
+    auto n = static_cast<size_t>(result);
+    buf.append(chunk, chunk + n);
+    offset += result;
+    size -= n;
+  }
+}
+
+void ostream::write_file_contents(const file_contents& fc) {
+  // Compressed and queued output has to go through the buffer.
+  if (compressor_ || nonblocking_) {
+    detail::write_file_contents(*this, fc);
+    return;
+  }
+  size_t size = clamp_file_range(fc.get_file(), fc.offset(), fc.size());
+  if (size == 0) return;
+  flush();
+  size_t n = transfer_file_range(fc.get_file().descriptor(), fc.offset(),
+                                 file_.descriptor(), size);
+  if (n == size) return;
+  auto rest = file_contents(fc.get_file(),
+                            fc.offset() + static_cast<long long>(n), size - n);
+  detail::write_file_contents(*this, rest);
 }
+#  endif  // FMT_USE_MMAP
 #endif  // FMT_USE_FCNTL
 FMT_END_NAMESPACE
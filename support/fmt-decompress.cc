@@ -0,0 +1,39 @@
+// Formatting library for C++ - decompressor for fmt::ostream output
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+//
+// Usage: fmt-decompress <file>...
+//
+// Writes the decompressed contents of files written with
+// fmt::output_file(path, fmt::compress = fmt::compression::fast) to stdout.
+
+#include <cstdio>
+#include <exception>
+
+#include "fmt/os.h"
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fmt::print(stderr, "usage: {} <file>...\n", argv[0]);
+    return 1;
+  }
+  char buf[65536];
+  for (int i = 1; i < argc; ++i) {
+    try {
+      auto in = fmt::input_file(argv[i]);
+      while (size_t n = in.read(buf, sizeof(buf))) {
+        if (std::fwrite(buf, 1, n, stdout) != n) {
+          fmt::print(stderr, "cannot write to stdout\n");
+          return 1;
+        }
+      }
+    } catch (const std::exception& e) {
+      fmt::print(stderr, "{}: {}\n", argv[i], e.what());
+      return 1;
+    }
+  }
+  return std::fflush(stdout) == 0 ? 0 : 1;
+}
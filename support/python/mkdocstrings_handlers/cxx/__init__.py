@@ -172,7 +172,8 @@ class CxxHandler(BaseHandler):
 
         headers = [
             'args.h', 'base.h', 'chrono.h', 'color.h', 'compile.h', 'format.h',
-            'os.h', 'ostream.h', 'printf.h', 'ranges.h', 'std.h', 'xchar.h'
+            'os.h', 'ostream.h', 'printf.h', 'ranges.h', 'std.h', 'table.h',
+            'xchar.h'
         ]
 
         # Run doxygen.
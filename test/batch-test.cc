@@ -0,0 +1,100 @@
+// Formatting library for C++ - parallel batch formatting tests
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+
+#include "fmt/batch.h"
+
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+auto expected(const std::vector<std::tuple<int, std::string, double>>& rows)
+    -> std::string {
+  auto result = std::string();
+  for (const auto& row : rows) {
+    result += fmt::format("{0:>5}|{1:<6}|{2:.2f}|{0}\n", std::get<0>(row),
+                          std::get<1>(row), std::get<2>(row));
+  }
+  return result;
+}
+
+auto make_rows(int n) -> std::vector<std::tuple<int, std::string, double>> {
+  auto rows = std::vector<std::tuple<int, std::string, double>>();
+  for (int i = 0; i < n; ++i)
+    rows.emplace_back(i, std::to_string(i * 7), i / 3.0);
+  return rows;
+}
+
+struct string_sink {
+  std::string& out;
+  int& calls;
+
+  void operator()(fmt::string_view s) {
+    out.append(s.data(), s.size());
+    ++calls;
+  }
+};
+}  // namespace
+
+TEST(batch_test, ordered_output) {
+  for (int n : {0, 1, 2, 100, 5000}) {
+    auto rows = make_rows(n);
+    for (unsigned threads : {1u, 2u, 4u}) {
+      auto out = std::string();
+      int calls = 0;
+      fmt::format_batch("{0:>5}|{1:<6}|{2:.2f}|{0}\n", rows,
+                        string_sink{out, calls}, threads, 64);
+      EXPECT_EQ(out, expected(rows)) << n << " rows, " << threads;
+      // Each chunk is written with a single call and output is not
+      // accumulated, even on a single thread.
+      EXPECT_LE(calls, 1 + (n + 62) / 64);
+      if (n > 65) {
+        EXPECT_GT(calls, 1);
+      }
+    }
+  }
+}
+
+TEST(batch_test, escapes_and_dynamic_specs) {
+  auto rows = std::vector<std::tuple<double, int, int, int>>();
+  auto expected = std::string();
+  for (int i = 0; i < 300; ++i) {
+    rows.emplace_back(i / 7.0, i % 13, i % 4, i);
+    expected += fmt::format("{{{:{}.{}f}}} {}\n", i / 7.0, i % 13, i % 4, i);
+  }
+  auto out = std::string();
+  int calls = 0;
+  fmt::format_batch("{{{:{}.{}f}}} {}\n", rows, string_sink{out, calls}, 3,
+                    16);
+  EXPECT_EQ(out, expected);
+}
+
+TEST(batch_test, file) {
+  auto rows = make_rows(1000);
+  FILE* f = std::tmpfile();
+  fmt::format_batch("{0:>5}|{1:<6}|{2:.2f}|{0}\n", rows, f, 4, 10);
+  std::rewind(f);
+  auto out = std::string();
+  char buf[4096];
+  while (size_t n = std::fread(buf, 1, sizeof(buf), f)) out.append(buf, n);
+  std::fclose(f);
+  EXPECT_EQ(out, expected(rows));
+}
+
+TEST(batch_test, sink_error) {
+  auto rows = make_rows(1000);
+  int calls = 0;
+  auto sink = [&](fmt::string_view) {
+    if (++calls == 3) throw std::runtime_error("sink error");
+  };
+  EXPECT_THROW(fmt::format_batch("{}{}{}", rows, sink, 4, 10),
+               std::runtime_error);
+  EXPECT_EQ(calls, 3);
+}
@@ -0,0 +1,332 @@
+// Formatting library for C++ - benchmark harness
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+
+#ifndef FMT_BENCH_H_
+#define FMT_BENCH_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+#endif
+
+#include "fmt/format.h"
+#include "fmt/table.h"
+
+namespace bench {
+
+// Prevents the compiler from optimizing away the computation of `value`.
+template <typename T> inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  (void)value;
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+#endif
+}
+
+// Counts CPU cycles. Core cycles from the performance monitoring unit are
+// preferred because they don't depend on the CPU frequency; the time stamp
+// counter, which ticks at a constant reference rate, is the fallback.
+class cycle_counter {
+ private:
+  int fd_ = -1;
+  const char* source_ = "none";
+
+ public:
+  cycle_counter() {
+#ifdef __linux__
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd_ >= 0) {
+      source_ = "cpu-cycles";
+      return;
+    }
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+    source_ = "tsc";
+#endif
+  }
+  ~cycle_counter() {
+#ifdef __linux__
+    if (fd_ >= 0) close(fd_);
+#endif
+  }
+  cycle_counter(const cycle_counter&) = delete;
+  void operator=(const cycle_counter&) = delete;
+
+  auto source() const -> const char* { return source_; }
+
+  auto read() const -> uint64_t {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      uint64_t count = 0;
+      if (::read(fd_, &count, sizeof(count)) == sizeof(count)) return count;
+      return 0;
+    }
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t lo = 0, hi = 0;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#elif defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+};
+
+struct options {
+  std::string filter;    // Only run benchmarks containing this substring.
+  int repetitions = 21;  // Number of timed samples per benchmark.
+  int warmup = 3;        // Number of untimed samples per benchmark.
+  double min_time_ms = 2;  // Minimum duration of a sample.
+  std::string json;        // Output file for JSON results, "-" for stdout.
+  std::string baseline;    // JSON results to compare against.
+  double threshold = 5;    // Regression threshold in percent.
+};
+
+inline auto parse_options(int argc, char** argv, options& opts) -> bool {
+  for (int i = 1; i < argc; ++i) {
+    auto arg = fmt::string_view(argv[i]);
+    auto value = [&](fmt::string_view name) -> const char* {
+      if (arg.size() <= name.size() || arg[name.size()] != '=' ||
+          std::strncmp(arg.data(), name.data(), name.size()) != 0) {
+        return nullptr;
+      }
+      return arg.data() + name.size() + 1;
+    };
+    if (const char* filter = value("--filter")) {
+      opts.filter = filter;
+    } else if (const char* repetitions = value("--repetitions")) {
+      opts.repetitions = std::max(1, std::atoi(repetitions));
+    } else if (const char* warmup = value("--warmup")) {
+      opts.warmup = std::max(0, std::atoi(warmup));
+    } else if (const char* min_time = value("--min-time-ms")) {
+      opts.min_time_ms = std::atof(min_time);
+    } else if (const char* json = value("--json")) {
+      opts.json = json;
+    } else if (const char* baseline = value("--baseline")) {
+      opts.baseline = baseline;
+    } else if (const char* threshold = value("--threshold")) {
+      opts.threshold = std::atof(threshold);
+    } else {
+      fmt::print(stderr,
+                 "usage: {} [--filter=<substring>] [--repetitions=<n>] "
+                 "[--warmup=<n>] [--min-time-ms=<ms>] [--json=<file>|-] "
+                 "[--baseline=<file>] [--threshold=<percent>]\n",
+                 argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+struct result {
+  std::string name;
+  uint64_t batch_size;  // Number of operations per sample.
+  double median_ns;
+  double p99_ns;
+  double median_cycles;
+};
+
+// Returns the value at percentile `p` of sorted samples.
+inline auto percentile(const std::vector<double>& sorted, double p) -> double {
+  auto index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+  return sorted[index];
+}
+
+// Reads results written by runner::write_json. Only the fields used for
+// comparison are parsed and the format is assumed to be one result per line.
+inline auto read_json(const std::string& filename, std::string& cycle_source)
+    -> std::vector<result> {
+  auto results = std::vector<result>();
+  FILE* f = std::fopen(filename.c_str(), "r");
+  if (!f) return results;
+  char line[1024];
+  while (std::fgets(line, sizeof(line), f)) {
+    char name[512];
+    auto r = result();
+    if (std::sscanf(line, " \"cycle_source\": \"%63[^\"]\"", name) == 1) {
+      cycle_source = name;
+    } else if (std::sscanf(line,
+                           " {\"name\": \"%511[^\"]\", \"batch_size\": %*u, "
+                           "\"median_ns\": %lf, \"p99_ns\": %lf, "
+                           "\"median_cycles\": %lf",
+                           name, &r.median_ns, &r.p99_ns,
+                           &r.median_cycles) == 4) {
+      r.name = name;
+      results.push_back(r);
+    }
+  }
+  std::fclose(f);
+  return results;
+}
+
+class runner {
+ private:
+  options opts_;
+  cycle_counter cycles_;
+  std::vector<result> results_;
+
+  using clock = std::chrono::steady_clock;
+
+  static auto elapsed_ns(clock::time_point start, clock::time_point end)
+      -> double {
+    return std::chrono::duration<double, std::nano>(end - start).count();
+  }
+
+  void write_json(FILE* f) const {
+    fmt::print(f, "{{\n  \"cycle_source\": \"{}\",\n  \"results\": [\n",
+               cycles_.source());
+    for (size_t i = 0; i < results_.size(); ++i) {
+      const result& r = results_[i];
+      fmt::print(f,
+                 "    {{\"name\": \"{}\", \"batch_size\": {}, "
+                 "\"median_ns\": {:.3f}, \"p99_ns\": {:.3f}, "
+                 "\"median_cycles\": {:.3f}}}{}\n",
+                 r.name, r.batch_size, r.median_ns, r.p99_ns, r.median_cycles,
+                 i + 1 < results_.size() ? "," : "");
+    }
+    fmt::print(f, "  ]\n}}\n");
+  }
+
+  // Compares results with the baseline and returns the number of regressions.
+  auto compare() const -> int {
+    auto baseline_source = std::string();
+    auto baseline = read_json(opts_.baseline, baseline_source);
+    if (baseline.empty()) {
+      fmt::print(stderr, "cannot read baseline {}\n", opts_.baseline);
+      return 1;
+    }
+    // Compare cycles if both runs count them the same way and time otherwise.
+    bool use_cycles = baseline_source == cycles_.source() &&
+                      baseline_source != "none";
+    auto t = fmt::table();
+    t.add_row("benchmark", "baseline", "current", "change");
+    for (size_t column = 1; column < 4; ++column)
+      t.set_align(column, fmt::align::right);
+    int regressions = 0;
+    for (const result& r : results_) {
+      auto it = std::find_if(
+          baseline.begin(), baseline.end(),
+          [&](const result& b) { return b.name == r.name; });
+      if (it == baseline.end()) continue;
+      double before = use_cycles ? it->median_cycles : it->median_ns;
+      double after = use_cycles ? r.median_cycles : r.median_ns;
+      double change = before > 0 ? (after - before) / before * 100 : 0;
+      bool regressed = change > opts_.threshold;
+      if (regressed) ++regressions;
+      t.add_cell("{}", r.name);
+      t.add_cell("{:.2f}", before);
+      t.add_cell("{:.2f}", after);
+      t.add_cell("{:+.1f}%{}", change, regressed ? " REGRESSION" : "");
+      t.end_row();
+    }
+    fmt::print("\ncomparison with {} ({}):\n{}", opts_.baseline,
+               use_cycles ? "cycles" : "ns", t);
+    if (regressions != 0) {
+      fmt::print("{} benchmark(s) regressed by more than {}%\n", regressions,
+                 opts_.threshold);
+    }
+    return regressions;
+  }
+
+ public:
+  explicit runner(const options& opts) : opts_(opts) {}
+
+  auto results() const -> const std::vector<result>& { return results_; }
+
+  // Measures the time and cycles per call of `f` which should pass its
+  // result to do_not_optimize.
+  template <typename F> void run(const std::string& name, F&& f) {
+    if (!opts_.filter.empty() && name.find(opts_.filter) == std::string::npos)
+      return;
+
+    // Find a batch size that makes a sample last at least min_time_ms.
+    uint64_t batch_size = 1;
+    double min_time_ns = opts_.min_time_ms * 1e6;
+    for (;;) {
+      auto start = clock::now();
+      for (uint64_t i = 0; i < batch_size; ++i) f();
+      if (elapsed_ns(start, clock::now()) >= min_time_ns ||
+          batch_size >= (uint64_t(1) << 30)) {
+        break;
+      }
+      batch_size *= 2;
+    }
+
+    for (int i = 0; i < opts_.warmup; ++i) {
+      for (uint64_t j = 0; j < batch_size; ++j) f();
+    }
+
+    auto ns = std::vector<double>();
+    auto cycles = std::vector<double>();
+    for (int i = 0; i < opts_.repetitions; ++i) {
+      auto start = clock::now();
+      uint64_t start_cycles = cycles_.read();
+      for (uint64_t j = 0; j < batch_size; ++j) f();
+      uint64_t end_cycles = cycles_.read();
+      auto end = clock::now();
+      auto n = static_cast<double>(batch_size);
+      ns.push_back(elapsed_ns(start, end) / n);
+      cycles.push_back(static_cast<double>(end_cycles - start_cycles) / n);
+    }
+    std::sort(ns.begin(), ns.end());
+    std::sort(cycles.begin(), cycles.end());
+    results_.push_back({name, batch_size, percentile(ns, 0.5),
+                        percentile(ns, 0.99), percentile(cycles, 0.5)});
+    const result& r = results_.back();
+    fmt::print(stderr,
+               "{:<40} {:>10.2f} ns {:>10.2f} ns p99 {:>10.1f} cycles\n",
+               r.name, r.median_ns, r.p99_ns, r.median_cycles);
+  }
+
+  // Writes the results and compares them with the baseline. Returns the
+  // process exit code.
+  auto finish() -> int {
+    if (opts_.json == "-") {
+      write_json(stdout);
+    } else if (!opts_.json.empty()) {
+      FILE* f = std::fopen(opts_.json.c_str(), "w");
+      if (!f) {
+        fmt::print(stderr, "cannot open {}\n", opts_.json);
+        return 1;
+      }
+      write_json(f);
+      std::fclose(f);
+    }
+    if (opts_.baseline.empty()) return 0;
+    return compare() != 0 ? 1 : 0;
+  }
+};
+
+}  // namespace bench
+
+#endif  // FMT_BENCH_H_
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+
+"""Measure compile time and code size of {fmt} call sites.
+
+Generates translation units with N call sites of fmt::format, FMT_COMPILE,
+fmt::print and the chrono and ranges formatters and compiles each of them
+in three modes:
+
+  header-only  with FMT_HEADER_ONLY
+  compiled     against the compiled library (--lib)
+  module       with `import fmt;` using src/fmt.cc (clang and gcc only)
+
+For each TU the compile wall time, peak compiler RSS and the .text size of
+the object file and of the linked executable are recorded. The report is
+printed as a table and can be saved as JSON (--json) to track it over time.
+
+Usage:
+  compile-bench.py --source-dir=<fmt> [--cxx=<compiler>] [--lib=<libfmt.a>]
+                   [--calls=100,1000] [--kinds=...] [--modes=...]
+                   [--json=<file>] [--work-dir=<dir>]
+"""
+
+import argparse, json, os, re, subprocess, sys, tempfile, time
+
+# Call site kinds: (headers, parameters, body). `{i}` in the body is replaced
+# with the index of the call site to make format strings distinct.
+KINDS = {
+    'format': (
+        ['fmt/format.h'], 'int a, double b, const char* s',
+        'return fmt::format("{i}: {{}} {{:>8.3f}} {{}}", a, b, s);'),
+    'compile': (
+        ['fmt/compile.h'], 'int a, double b, const char* s',
+        'return fmt::format(FMT_COMPILE("{i}: {{}} {{:>8.3f}} {{}}"), '
+        'a, b, s);'),
+    'print': (
+        ['fmt/format.h'], 'int a, double b, const char* s',
+        'fmt::print("{i}: {{}} {{:>8.3f}} {{}}\\n", a, b, s); return {{}};'),
+    'chrono': (
+        ['fmt/chrono.h'], 'const std::tm& t, std::chrono::milliseconds d',
+        'return fmt::format("{i}: {{:%Y-%m-%d %H:%M:%S}} {{}}", t, d);'),
+    'ranges': (
+        ['fmt/ranges.h'],
+        'const std::vector<int>& v, const std::map<int, double>& m',
+        'return fmt::format("{i}: {{}} {{}}", v, m);'),
+}
+
+MODES = ['header-only', 'compiled', 'module']
+
+STD_HEADERS = ['chrono', 'ctime', 'map', 'string', 'vector']
+
+
+def generate(kind, mode, calls):
+    headers, params, body = KINDS[kind]
+    lines = []
+    if mode == 'module':
+        lines += ['#include <{}>'.format(h) for h in STD_HEADERS]
+        lines.append('import fmt;')
+    else:
+        lines += ['#include <{}>'.format(h) for h in STD_HEADERS + headers]
+    lines.append('')
+    for i in range(calls):
+        lines.append('std::string f{}({}) {{'.format(i, params))
+        lines.append('  ' + body.format(i=i))
+        lines.append('}')
+    lines.append('')
+    lines.append('int main() {}')
+    return '\n'.join(lines) + '\n'
+
+
+class Result:
+    def __init__(self, returncode, seconds, max_rss_kib, output):
+        self.returncode = returncode
+        self.seconds = seconds
+        self.max_rss_kib = max_rss_kib
+        self.output = output
+
+
+def run(cmd, cwd):
+    """Runs a command and returns its wall time and the peak RSS including
+    the processes it spawns such as cc1plus."""
+    with tempfile.TemporaryFile() as output:
+        start = time.monotonic()
+        p = subprocess.Popen(cmd, cwd=cwd, stdout=output, stderr=output)
+        _, status, usage = os.wait4(p.pid, 0)
+        seconds = time.monotonic() - start
+        p.returncode = os.waitstatus_to_exitcode(status)
+        output.seek(0)
+        # ru_maxrss is in kilobytes on Linux and in bytes on macOS.
+        max_rss = usage.ru_maxrss
+        if sys.platform == 'darwin':
+            max_rss //= 1024
+        return Result(p.returncode, seconds, max_rss,
+                      output.read().decode(errors='replace'))
+
+
+def text_size(size_tool, filename):
+    """Returns the total size of .text sections in an object or executable."""
+    output = subprocess.check_output([size_tool, '-A', filename]).decode()
+    total = 0
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and re.match(r'(\.text|__text)(\.|$)', fields[0]):
+            total += int(fields[1])
+    return total
+
+
+class Bench:
+    def __init__(self, args):
+        self.args = args
+        self.include_dir = os.path.join(args.source_dir, 'include')
+        self.work_dir = os.path.abspath(args.work_dir)
+        os.makedirs(self.work_dir, exist_ok=True)
+        version = subprocess.check_output([args.cxx, '--version']).decode()
+        self.is_clang = 'clang' in version
+        self.module_flags = []
+        self.module_objects = []
+        self.module_error = None
+
+    def flags(self, mode):
+        flags = ['-O2', '-I', self.include_dir] + self.args.flags.split()
+        if mode == 'header-only':
+            return ['-std=c++17', '-DFMT_HEADER_ONLY'] + flags
+        if mode == 'compiled':
+            return ['-std=c++17'] + flags
+        return ['-std=c++20'] + flags + self.module_flags
+
+    def build_module(self):
+        """Builds the fmt module. This is done once and is not measured."""
+        source = os.path.join(self.args.source_dir, 'src', 'fmt.cc')
+        obj = os.path.join(self.work_dir, 'fmt-module.o')
+        common = [self.args.cxx, '-std=c++20', '-O2', '-I', self.include_dir]
+        if self.is_clang:
+            pcm = os.path.join(self.work_dir, 'fmt.pcm')
+            steps = [
+                common + ['-x', 'c++-module', '--precompile', '-o', pcm,
+                          source],
+                [self.args.cxx, '-std=c++20', '-c', '-o', obj, pcm]]
+            flags = ['-fmodule-file=fmt=' + pcm]
+        else:
+            # gcc writes the compiled module interface to gcm.cache in the
+            # working directory where it is found by importers.
+            steps = [common + ['-fmodules-ts', '-c', '-o', obj, source]]
+            flags = ['-fmodules-ts']
+        for cmd in steps:
+            result = run(cmd, self.work_dir)
+            if result.returncode != 0:
+                self.module_error = result.output
+                return False
+        self.module_flags = flags
+        self.module_objects = [obj]
+        return True
+
+    def measure(self, kind, mode, calls):
+        name = '{}-{}-{}'.format(kind, mode, calls)
+        source = os.path.join(self.work_dir, name + '.cc')
+        obj = os.path.join(self.work_dir, name + '.o')
+        exe = os.path.join(self.work_dir, name)
+        with open(source, 'w') as f:
+            f.write(generate(kind, mode, calls))
+        compile = [self.args.cxx] + self.flags(mode)
+        compile += ['-c', '-o', obj, source]
+        best = None
+        for i in range(self.args.repetitions):
+            result = run(compile, self.work_dir)
+            if result.returncode != 0:
+                return {'error': result.output}
+            if best is None or result.seconds < best.seconds:
+                best = result
+        link = [self.args.cxx, '-o', exe, obj]
+        if mode == 'compiled':
+            link.append(self.args.lib)
+        elif mode == 'module':
+            link += self.module_objects
+        result = run(link, self.work_dir)
+        if result.returncode != 0:
+            return {'error': result.output}
+        return {
+            'compile_seconds': round(best.seconds, 3),
+            'max_rss_kib': best.max_rss_kib,
+            'object_text_bytes': text_size(self.args.size, obj),
+            'executable_text_bytes': text_size(self.args.size, exe)}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Measure compile time and code size of {fmt} call sites.')
+    parser.add_argument('--cxx', default=os.environ.get('CXX', 'c++'),
+                        help='C++ compiler')
+    parser.add_argument('--source-dir', required=True,
+                        help='{fmt} source directory')
+    parser.add_argument('--lib', help='library used in the compiled mode')
+    parser.add_argument('--calls', default='100,1000',
+                        help='comma-separated numbers of call sites per TU')
+    parser.add_argument('--kinds', default=','.join(KINDS),
+                        help='comma-separated kinds of call sites')
+    parser.add_argument('--modes', default=','.join(MODES),
+                        help='comma-separated build modes')
+    parser.add_argument('--flags', default='', help='extra compiler flags')
+    parser.add_argument('--repetitions', type=int, default=1,
+                        help='number of compilations, the fastest is reported')
+    parser.add_argument('--size', default='size', help='size tool')
+    parser.add_argument('--work-dir', default='compile-bench',
+                        help='directory for generated files')
+    parser.add_argument('--json', help='file to write the report to')
+    args = parser.parse_args()
+
+    bench = Bench(args)
+    modes = args.modes.split(',')
+    if 'compiled' in modes and not args.lib:
+        print('skipping compiled mode: --lib is not specified',
+              file=sys.stderr)
+        modes.remove('compiled')
+    if 'module' in modes and not bench.build_module():
+        print('skipping module mode: cannot build the fmt module\n' +
+              bench.module_error, file=sys.stderr)
+        modes.remove('module')
+
+    results = []
+    row = '{:<8} {:<12} {:>6} {:>8} {:>9} {:>10} {:>10}'
+    print(row.format('kind', 'mode', 'calls', 'time, s', 'RSS, MiB',
+                     'obj .text', 'exe .text'))
+    for calls in [int(n) for n in args.calls.split(',')]:
+        for kind in args.kinds.split(','):
+            for mode in modes:
+                # Macros such as FMT_COMPILE are not exported from modules.
+                if kind == 'compile' and mode == 'module':
+                    continue
+                r = bench.measure(kind, mode, calls)
+                r.update({'kind': kind, 'mode': mode, 'calls': calls})
+                results.append(r)
+                if 'error' in r:
+                    print(row.format(kind, mode, calls, 'error', '', '', ''))
+                    print(r['error'], file=sys.stderr)
+                    continue
+                print(row.format(kind, mode, calls, r['compile_seconds'],
+                                 round(r['max_rss_kib'] / 1024, 1),
+                                 r['object_text_bytes'],
+                                 r['executable_text_bytes']), flush=True)
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump({'compiler': args.cxx, 'flags': args.flags,
+                       'results': results}, f, indent=2)
+    return 1 if any('error' in r for r in results) else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
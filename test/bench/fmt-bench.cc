@@ -0,0 +1,331 @@
+// Formatting library for C++ - microbenchmarks
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+//
+// Usage: fmt-bench [--filter=<substring>] [--json=<file>]
+//                  [--baseline=<file>] [--threshold=<percent>]
+//
+// Results can be saved with --json and later passed as --baseline to report
+// benchmarks that regressed by more than the threshold.
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "fmt/args.h"
+#include "fmt/chrono.h"
+#include "fmt/color.h"
+#include "fmt/compile.h"
+#include "fmt/format.h"
+#include "fmt/os.h"
+#include "fmt/printf.h"
+#include "fmt/ranges.h"
+
+#ifdef _WIN32
+#  define FMT_BENCH_NULL_DEVICE "NUL"
+#else
+#  define FMT_BENCH_NULL_DEVICE "/dev/null"
+#endif
+
+namespace {
+
+// Formats into a buffer that is reused between iterations to measure
+// formatting rather than allocation.
+fmt::memory_buffer buf;
+
+template <typename... T>
+void format_to_buffer(fmt::format_string<T...> fmt, T&&... args) {
+  buf.clear();
+  fmt::format_to(fmt::appender(buf), fmt, static_cast<T&&>(args)...);
+  bench::do_not_optimize(buf.data());
+}
+
+// Returns a value that the compiler can't constant-fold.
+template <typename T> auto opaque(T value) -> T {
+  bench::do_not_optimize(value);
+  return value;
+}
+
+template <typename T>
+void add_int_benchmarks(bench::runner& r, const char* name) {
+  // Cast back to T because the division promotes small types to int.
+  auto value = opaque(static_cast<T>(std::numeric_limits<T>::max() / 3));
+  r.run(fmt::format("int/{}/dec", name),
+        [=] { format_to_buffer("{}", value); });
+  r.run(fmt::format("int/{}/hex", name),
+        [=] { format_to_buffer("{:x}", value); });
+  r.run(fmt::format("int/{}/oct", name),
+        [=] { format_to_buffer("{:o}", value); });
+  r.run(fmt::format("int/{}/bin", name),
+        [=] { format_to_buffer("{:b}", value); });
+  r.run(fmt::format("int/{}/group-digits", name),
+        [=] { format_to_buffer("{}", fmt::group_digits(value)); });
+}
+
+void add_bigint_benchmarks(bench::runner& r) {
+  for (size_t bits : {256, 4096, 65536}) {
+    auto limbs = std::vector<uint64_t>(bits / 64);
+    for (size_t i = 0; i < limbs.size(); ++i)
+      limbs[i] = opaque(0x9e3779b97f4a7c15 * (i + 1));
+    r.run(fmt::format("bigint/{}/dec", bits), [=] {
+      format_to_buffer("{}", fmt::bigint_view(limbs));
+    });
+    r.run(fmt::format("bigint/{}/hex", bits), [=] {
+      format_to_buffer("{:x}", fmt::bigint_view(limbs));
+    });
+  }
+}
+
+void add_float_benchmarks(bench::runner& r) {
+  auto d = opaque(1.2345678901234567e-42);
+  auto f = opaque(3.14159f);
+  r.run("float/double/shortest", [=] { format_to_buffer("{}", d); });
+  r.run("float/float/shortest", [=] { format_to_buffer("{}", f); });
+  r.run("float/double/fixed",
+        [=] { format_to_buffer("{:.6f}", d * 1e45); });
+  r.run("float/double/fixed-large-precision",
+        [=] { format_to_buffer("{:.30f}", d); });
+  r.run("float/double/exp", [=] { format_to_buffer("{:e}", d); });
+  r.run("float/double/general", [=] { format_to_buffer("{:g}", d); });
+}
+
+void add_string_benchmarks(bench::runner& r) {
+  auto s = std::string(opaque("benchmark"));
+  r.run("string/plain", [&] { format_to_buffer("{}", s); });
+  r.run("string/width", [&] { format_to_buffer("{:>20}", s); });
+  r.run("string/fill-center", [&] { format_to_buffer("{:*^30}", s); });
+  r.run("string/precision", [&] { format_to_buffer("{:.4}", s); });
+  r.run("string/debug", [&] { format_to_buffer("{:?}", s); });
+  auto text = std::string(200, 'x');
+  r.run("string/debug-long", [&] { format_to_buffer("{:?}", text); });
+  r.run("string/width-long", [&] { format_to_buffer("{:>250}", text); });
+  auto long_format = text + "{}" + text;
+  r.run("string/long-format", [&] {
+    buf.clear();
+    fmt::vformat_to(fmt::appender(buf), long_format, fmt::make_format_args(s));
+    bench::do_not_optimize(buf.data());
+  });
+  r.run("string/mixed", [&] {
+    format_to_buffer("Hello, {}. The answer is {} and {}.", 1, 2345, 6789);
+  });
+  r.run("string/format", [&] {
+    auto result = fmt::format("Hello, {}. The answer is {}.", s, 42);
+    bench::do_not_optimize(result.data());
+  });
+}
+
+void add_chrono_benchmarks(bench::runner& r) {
+  auto tp = std::chrono::system_clock::time_point(
+      std::chrono::seconds(opaque(1700000000)));
+  auto tm = fmt::gmtime(std::chrono::system_clock::to_time_t(tp));
+  auto d = std::chrono::milliseconds(opaque(123456));
+  r.run("chrono/tm", [&] { format_to_buffer("{:%Y-%m-%d %H:%M:%S}", tm); });
+  r.run("chrono/time_point", [&] { format_to_buffer("{}", tp); });
+  r.run("chrono/duration", [&] { format_to_buffer("{}", d); });
+  r.run("chrono/duration-spec",
+        [&] { format_to_buffer("{:%H:%M:%S}", d); });
+}
+
+void add_range_benchmarks(bench::runner& r) {
+  auto v = std::vector<int>{1, 22, 333, 4444, 55555, 666666, 7777777};
+  auto strings = std::vector<std::string>{"alpha", "beta", "gamma", "delta"};
+  r.run("ranges/vector-int", [&] { format_to_buffer("{}", v); });
+  r.run("ranges/vector-string", [&] { format_to_buffer("{}", strings); });
+  r.run("ranges/join", [&] { format_to_buffer("{}", fmt::join(v, ", ")); });
+}
+
+void add_color_benchmarks(bench::runner& r) {
+  r.run("color/fg", [] {
+    buf.clear();
+    fmt::format_to(fmt::appender(buf), fmt::fg(fmt::color::red), "{}", 42);
+    bench::do_not_optimize(buf.data());
+  });
+  r.run("color/emphasis", [] {
+    buf.clear();
+    fmt::format_to(fmt::appender(buf),
+                   fmt::emphasis::bold | fmt::bg(fmt::color::blue), "{}",
+                   "text");
+    bench::do_not_optimize(buf.data());
+  });
+}
+
+void add_printf_benchmarks(bench::runner& r) {
+  r.run("printf/mixed", [] {
+    auto result = fmt::sprintf("%d %s %.2f", opaque(42), "abc", 1.5);
+    bench::do_not_optimize(result.data());
+  });
+  r.run("printf/width", [] {
+    auto result = fmt::sprintf("%10d|%-10s", opaque(42), "abc");
+    bench::do_not_optimize(result.data());
+  });
+}
+
+void add_compile_benchmarks(bench::runner& r) {
+  r.run("compile/int", [] {
+    char out[32];
+    auto end = fmt::format_to(out, FMT_COMPILE("{}"), opaque(123456789));
+    bench::do_not_optimize(end);
+  });
+  r.run("compile/mixed", [] {
+    buf.clear();
+    fmt::format_to(fmt::appender(buf),
+                   FMT_COMPILE("Hello, {}. The answer is {} and {}."), 1,
+                   opaque(2345), 6789);
+    bench::do_not_optimize(buf.data());
+  });
+  r.run("compile/format", [] {
+    auto result = fmt::format(FMT_COMPILE("{}:{}"), "key", opaque(42));
+    bench::do_not_optimize(result.data());
+  });
+}
+
+void add_print_benchmarks(bench::runner& r) {
+  FILE* f = std::fopen(FMT_BENCH_NULL_DEVICE, "w");
+  if (f) {
+    r.run("print/file", [=] { fmt::print(f, "The answer is {}.\n", 42); });
+    r.run("print/file-println",
+          [=] { fmt::println(f, "{} {}", 42, "abc"); });
+    std::fclose(f);
+  }
+#if FMT_USE_FCNTL
+  auto out = fmt::output_file(FMT_BENCH_NULL_DEVICE);
+  r.run("print/output_file", [&] { out.print("The answer is {}.\n", 42); });
+  auto compressed = fmt::output_file(FMT_BENCH_NULL_DEVICE,
+                                     fmt::compress = fmt::compression::fast);
+  r.run("print/output_file_compressed",
+        [&] { compressed.print("The answer is {}.\n", 42); });
+#endif
+#if FMT_USE_MMAP
+  {
+    const char* path = "fmt-bench-flight-recorder";
+    auto rec = fmt::flight_recorder(path, 1 << 20);
+    r.run("print/flight_recorder",
+          [&] { rec.print("The answer is {}.", 42); });
+    std::remove(path);
+  }
+  {
+    const char* path = "fmt-bench-file-contents";
+    auto content = std::string(1 << 20, 'x');
+    fmt::output_file(path).print("{}", content);
+    auto in = fmt::file(path, fmt::file::RDONLY);
+    r.run("print/file_contents",
+          [&] { out.print("{}", fmt::file_contents(in)); });
+    auto contents = fmt::memory_buffer();
+    r.run("format_to/file_contents", [&] {
+      contents.clear();
+      fmt::format_to(std::back_inserter(contents), "{}",
+                     fmt::file_contents(in));
+      bench::do_not_optimize(contents.data());
+    });
+    std::remove(path);
+  }
+#endif
+}
+
+// Output iterators that are written through a stash buffer.
+void add_output_benchmarks(bench::runner& r) {
+  auto text = std::string(opaque(1000), 'x');
+  auto d = std::deque<char>();
+  r.run("output/deque", [&] {
+    d.clear();
+    fmt::format_to(std::back_inserter(d), "{}", text);
+    bench::do_not_optimize(&d.back());
+  });
+  auto v = std::vector<char>(text.size());
+  r.run("output/vector-iterator", [&] {
+    fmt::format_to(v.begin(), "{}", text);
+    bench::do_not_optimize(v.data());
+  });
+}
+
+// Cache keys built by hashing the formatted output.
+void add_hash_benchmarks(bench::runner& r) {
+  auto name = std::string(opaque("session"));
+  auto id = opaque(123456789);
+  r.run("hash/std-hash-format", [&] {
+    auto key = std::hash<std::string>()(fmt::format("{}:{}:{}", name, id, 1));
+    bench::do_not_optimize(key);
+  });
+  r.run("hash/fnv1a", [&] {
+    bench::do_not_optimize(fmt::format_hash("{}:{}:{}", name, id, 1));
+  });
+  r.run("hash/xxhash64", [&] {
+    bench::do_not_optimize(
+        fmt::format_hash<fmt::xxhash64_hasher>("{}:{}:{}", name, id, 1));
+  });
+  auto text = std::string(opaque(4096), 'x');
+  r.run("hash/std-hash-format-long", [&] {
+    auto key = std::hash<std::string>()(fmt::format("{}", text));
+    bench::do_not_optimize(key);
+  });
+  r.run("hash/xxhash64-long", [&] {
+    bench::do_not_optimize(
+        fmt::format_hash<fmt::xxhash64_hasher>("{}", text));
+  });
+}
+
+// Regression cases for inputs found by the perf fuzzer (test/fuzzing/perf.cc)
+// for which the time per output byte is unusually high.
+void add_pathological_benchmarks(bench::runner& r) {
+  auto tiny = opaque(5e-324);
+  // Large precision that requires the Dragon4 fallback.
+  r.run("pathological/dragon-exp-precision",
+        [=] { format_to_buffer("{:.5000e}", tiny); });
+  // Most of the computed digits are removed as trailing zeros.
+  r.run("pathological/dragon-general-precision",
+        [=] { format_to_buffer("{:.9999g}", opaque(1.2345678e-300)); });
+  r.run("pathological/width",
+        [=] { format_to_buffer("{:>1000000}", "abc"); });
+  r.run("pathological/dynamic-width",
+        [=] { format_to_buffer("{:{}}", 42, opaque(100000)); });
+  // Named arguments are looked up by a linear search.
+  auto store = fmt::dynamic_format_arg_store<fmt::format_context>();
+  for (int i = 0; i < 256; ++i)
+    store.push_back(fmt::arg(fmt::format("a{}", i).c_str(), i));
+  auto last = std::string();
+  for (int i = 0; i < 100; ++i) last += "{a255}";
+  r.run("pathological/named-args", [&] {
+    buf.clear();
+    fmt::vformat_to(fmt::appender(buf), last, store);
+    bench::do_not_optimize(buf.data());
+  });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  auto opts = bench::options();
+  if (!bench::parse_options(argc, argv, opts)) return 1;
+  bench::runner r(opts);
+
+  add_int_benchmarks<int8_t>(r, "int8");
+  add_int_benchmarks<uint8_t>(r, "uint8");
+  add_int_benchmarks<int16_t>(r, "int16");
+  add_int_benchmarks<uint16_t>(r, "uint16");
+  add_int_benchmarks<int32_t>(r, "int32");
+  add_int_benchmarks<uint32_t>(r, "uint32");
+  add_int_benchmarks<int64_t>(r, "int64");
+  add_int_benchmarks<uint64_t>(r, "uint64");
+  add_bigint_benchmarks(r);
+  add_float_benchmarks(r);
+  add_string_benchmarks(r);
+  add_chrono_benchmarks(r);
+  add_range_benchmarks(r);
+  add_color_benchmarks(r);
+  add_printf_benchmarks(r);
+  add_compile_benchmarks(r);
+  add_print_benchmarks(r);
+  add_output_benchmarks(r);
+  add_hash_benchmarks(r);
+  add_pathological_benchmarks(r);
+
+  return r.finish();
+}
@@ -0,0 +1,376 @@
+// Formatting library for C++ - multi-threaded print benchmark
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+//
+// Usage: print-bench [--max-threads=<n>] [--ops=<n>] [--filter=<substring>]
+//                    [--file=<path>] [--json=<file>|-]
+//
+// Runs 1, 2, 4, ... up to max-threads threads printing to the same sink and
+// reports throughput and per-call latency percentiles for each thread count,
+// so that contention on the stdio lock and on shared streams is visible.
+//
+// Sinks are the null device, a pipe drained by a separate thread and a
+// regular file. Print paths are fmt::print and fmt::println to a shared
+// FILE*, and fmt::ostream and std::ostream shared between threads. The
+// streams are not thread-safe so they are guarded by a mutex, as in user
+// code that shares them.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "fmt/os.h"
+#include "fmt/ostream.h"
+#include "fmt/table.h"
+
+#ifndef _WIN32
+#  include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#  define FMT_BENCH_NULL_DEVICE "NUL"
+#else
+#  define FMT_BENCH_NULL_DEVICE "/dev/null"
+#endif
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+struct print_options {
+  unsigned max_threads = 0;  // 0 means max(4, hardware concurrency).
+  int ops = 20000;           // Number of calls per thread.
+  std::string filter;        // Only run cases containing this substring.
+  std::string file = "print-bench.tmp";  // Regular file used as a sink.
+  std::string json;  // Output file for JSON results, "-" for stdout.
+};
+
+auto parse_options(int argc, char** argv, print_options& opts) -> bool {
+  for (int i = 1; i < argc; ++i) {
+    auto arg = std::string(argv[i]);
+    auto pos = arg.find('=');
+    auto name = arg.substr(0, pos);
+    auto value = pos != std::string::npos ? arg.substr(pos + 1) : "";
+    if (name == "--max-threads" && !value.empty()) {
+      opts.max_threads =
+          static_cast<unsigned>(std::max(1, std::atoi(value.c_str())));
+    } else if (name == "--ops" && !value.empty()) {
+      opts.ops = std::max(1, std::atoi(value.c_str()));
+    } else if (name == "--filter") {
+      opts.filter = value;
+    } else if (name == "--file" && !value.empty()) {
+      opts.file = value;
+    } else if (name == "--json" && !value.empty()) {
+      opts.json = value;
+    } else {
+      fmt::print(stderr,
+                 "usage: {} [--max-threads=<n>] [--ops=<n>] "
+                 "[--filter=<substring>] [--file=<path>] [--json=<file>|-]\n",
+                 argv[0]);
+      return false;
+    }
+  }
+  if (opts.max_threads == 0)
+    opts.max_threads = std::max(4u, std::thread::hardware_concurrency());
+  return true;
+}
+
+// A destination of the output opened by path. The pipe sink opens its write
+// end via /dev/fd so that all print paths can open it the same way.
+class sink {
+ private:
+  std::string path_;
+#ifndef _WIN32
+  int read_fd_ = -1;
+  int write_fd_ = -1;
+  std::thread drain_;
+#endif
+
+ public:
+  explicit sink(std::string path) : path_(std::move(path)) {}
+
+#ifndef _WIN32
+  struct pipe_tag {};
+
+  explicit sink(pipe_tag) {
+    int fds[2];
+    if (::pipe(fds) != 0)
+      throw fmt::system_error(errno, "cannot create pipe");
+    read_fd_ = fds[0];
+    write_fd_ = fds[1];
+    path_ = fmt::format("/dev/fd/{}", write_fd_);
+    drain_ = std::thread([this] {
+      char buffer[65536];
+      while (::read(read_fd_, buffer, sizeof(buffer)) > 0) {
+      }
+    });
+  }
+
+  ~sink() {
+    if (write_fd_ < 0) return;
+    // The drain thread exits when all write ends have been closed.
+    ::close(write_fd_);
+    drain_.join();
+    ::close(read_fd_);
+  }
+#endif
+
+  sink(const sink&) = delete;
+  void operator=(const sink&) = delete;
+
+  auto path() const -> const std::string& { return path_; }
+};
+
+// Prints `count` messages from thread `thread_index` recording the latency of
+// each call in nanoseconds.
+using print_fun = std::function<void(unsigned thread_index, int count,
+                                     std::vector<double>& latencies)>;
+
+template <typename F>
+void time_calls(int count, std::vector<double>& latencies, F f) {
+  for (int i = 0; i < count; ++i) {
+    auto start = clock::now();
+    f(i);
+    auto end = clock::now();
+    latencies.push_back(
+        std::chrono::duration<double, std::nano>(end - start).count());
+  }
+}
+
+auto open_file(const std::string& path) -> std::shared_ptr<FILE> {
+  FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) throw fmt::system_error(errno, "cannot open {}", path);
+  return std::shared_ptr<FILE>(f, std::fclose);
+}
+
+// Functions that open the sink at `path` and return a function printing to
+// it. `state` keeps the stream open until it is destroyed.
+
+auto open_print(const std::string& path, std::shared_ptr<void>& state)
+    -> print_fun {
+  auto f = open_file(path);
+  state = f;
+  return [f](unsigned thread_index, int count, std::vector<double>& out) {
+    time_calls(count, out, [&](int i) {
+      fmt::print(f.get(), "thread {} message {} value {}\n", thread_index, i,
+                 i * 0.5);
+    });
+  };
+}
+
+auto open_println(const std::string& path, std::shared_ptr<void>& state)
+    -> print_fun {
+  auto f = open_file(path);
+  state = f;
+  return [f](unsigned thread_index, int count, std::vector<double>& out) {
+    time_calls(count, out, [&](int i) {
+      fmt::println(f.get(), "thread {} message {} value {}", thread_index, i,
+                   i * 0.5);
+    });
+  };
+}
+
+#if FMT_USE_FCNTL
+auto open_fmt_ostream(const std::string& path, std::shared_ptr<void>& state)
+    -> print_fun {
+  struct shared_stream {
+    fmt::ostream out;
+    std::mutex mutex;
+    explicit shared_stream(const std::string& path)
+        : out(fmt::output_file(path)) {}
+  };
+  auto s = std::make_shared<shared_stream>(path);
+  state = s;
+  return [s](unsigned thread_index, int count, std::vector<double>& out) {
+    time_calls(count, out, [&](int i) {
+      std::lock_guard<std::mutex> lock(s->mutex);
+      s->out.print("thread {} message {} value {}\n", thread_index, i,
+                   i * 0.5);
+    });
+  };
+}
+#endif
+
+auto open_std_ostream(const std::string& path, std::shared_ptr<void>& state)
+    -> print_fun {
+  struct shared_stream {
+    std::ofstream out;
+    std::mutex mutex;
+  };
+  auto s = std::make_shared<shared_stream>();
+  s->out.open(path);
+  if (!s->out) throw std::runtime_error("cannot open " + path);
+  state = s;
+  return [s](unsigned thread_index, int count, std::vector<double>& out) {
+    time_calls(count, out, [&](int i) {
+      std::lock_guard<std::mutex> lock(s->mutex);
+      fmt::print(s->out, "thread {} message {} value {}\n", thread_index, i,
+                 i * 0.5);
+    });
+  };
+}
+
+struct print_path {
+  const char* name;
+  print_fun (*open)(const std::string& path, std::shared_ptr<void>& state);
+};
+
+const print_path print_paths[] = {
+    {"print(FILE*)", open_print},
+    {"println(FILE*)", open_println},
+#if FMT_USE_FCNTL
+    {"fmt::ostream", open_fmt_ostream},
+#endif
+    {"std::ostream", open_std_ostream},
+};
+
+struct result {
+  std::string path;
+  std::string sink;
+  unsigned threads;
+  double ops_per_sec;
+  double p50_ns;
+  double p99_ns;
+  double p999_ns;
+  double max_ns;
+};
+
+// Runs `print` on `num_threads` threads started at the same time.
+auto run(const print_fun& print, unsigned num_threads, int ops) -> result {
+  auto latencies = std::vector<std::vector<double>>(num_threads);
+  for (auto& l : latencies) l.reserve(static_cast<size_t>(ops));
+  auto ready = std::atomic<unsigned>(0);
+  auto go = std::atomic<bool>(false);
+  auto threads = std::vector<std::thread>();
+  for (unsigned i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&, i] {
+      ++ready;
+      while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+      print(i, ops, latencies[i]);
+    });
+  }
+  while (ready.load() != num_threads) std::this_thread::yield();
+  auto start = clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto& t : threads) t.join();
+  auto end = clock::now();
+
+  auto all = std::vector<double>();
+  for (const auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+  std::sort(all.begin(), all.end());
+  double seconds = std::chrono::duration<double>(end - start).count();
+  auto r = result();
+  r.threads = num_threads;
+  r.ops_per_sec = static_cast<double>(all.size()) / seconds;
+  r.p50_ns = bench::percentile(all, 0.5);
+  r.p99_ns = bench::percentile(all, 0.99);
+  r.p999_ns = bench::percentile(all, 0.999);
+  r.max_ns = all.back();
+  return r;
+}
+
+void write_json(FILE* f, const std::vector<result>& results) {
+  fmt::print(f, "{{\n  \"results\": [\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const result& r = results[i];
+    fmt::print(f,
+               "    {{\"path\": \"{}\", \"sink\": \"{}\", \"threads\": {}, "
+               "\"ops_per_sec\": {:.0f}, \"p50_ns\": {:.1f}, "
+               "\"p99_ns\": {:.1f}, \"p999_ns\": {:.1f}, "
+               "\"max_ns\": {:.1f}}}{}\n",
+               r.path, r.sink, r.threads, r.ops_per_sec, r.p50_ns, r.p99_ns,
+               r.p999_ns, r.max_ns, i + 1 < results.size() ? "," : "");
+  }
+  fmt::print(f, "  ]\n}}\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  auto opts = print_options();
+  if (!parse_options(argc, argv, opts)) return 1;
+
+  auto thread_counts = std::vector<unsigned>();
+  for (unsigned n = 1; n < opts.max_threads; n *= 2)
+    thread_counts.push_back(n);
+  thread_counts.push_back(opts.max_threads);
+
+  auto sink_names = std::vector<const char*>{"null", "file"};
+#ifndef _WIN32
+  sink_names.insert(sink_names.begin() + 1, "pipe");
+#endif
+
+  auto results = std::vector<result>();
+  auto t = fmt::table();
+  t.add_row("path", "sink", "threads", "Mops/s", "p50 ns", "p99 ns",
+            "p99.9 ns", "max ns");
+  for (size_t column = 2; column < 8; ++column)
+    t.set_align(column, fmt::align::right);
+  for (const print_path& path : print_paths) {
+    for (const char* sink_name : sink_names) {
+      auto name = fmt::format("{}/{}", path.name, sink_name);
+      if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos)
+        continue;
+      for (unsigned num_threads : thread_counts) {
+        auto s = std::unique_ptr<sink>();
+        if (std::strcmp(sink_name, "null") == 0)
+          s.reset(new sink(FMT_BENCH_NULL_DEVICE));
+        else if (std::strcmp(sink_name, "file") == 0)
+          s.reset(new sink(opts.file));
+#ifndef _WIN32
+        else
+          s.reset(new sink(sink::pipe_tag()));
+#endif
+        auto r = result();
+        {
+          auto state = std::shared_ptr<void>();
+          auto print = path.open(s->path(), state);
+          r = run(print, num_threads, opts.ops);
+        }
+        r.path = path.name;
+        r.sink = sink_name;
+        results.push_back(r);
+        t.add_cell("{}", r.path);
+        t.add_cell("{}", r.sink);
+        t.add_cell("{}", r.threads);
+        t.add_cell("{:.2f}", r.ops_per_sec / 1e6);
+        t.add_cell("{:.0f}", r.p50_ns);
+        t.add_cell("{:.0f}", r.p99_ns);
+        t.add_cell("{:.0f}", r.p999_ns);
+        t.add_cell("{:.0f}", r.max_ns);
+        t.end_row();
+      }
+    }
+  }
+  std::remove(opts.file.c_str());
+  fmt::print("{}", t);
+
+  if (opts.json == "-") {
+    write_json(stdout, results);
+  } else if (!opts.json.empty()) {
+    FILE* f = std::fopen(opts.json.c_str(), "w");
+    if (!f) {
+      fmt::print(stderr, "cannot open {}\n", opts.json);
+      return 1;
+    }
+    write_json(f, results);
+    std::fclose(f);
+  }
+  return 0;
+}
@@ -0,0 +1,210 @@
+// Formatting library for C++ - replay of captured formatting calls
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+//
+// Usage: replay-bench <trace> [--repetitions=<n>] [--json=<file>]
+//                     [--baseline=<file>] [--threshold=<percent>]
+//
+// Replays a trace recorded with fmt::start_capture in a program compiled
+// with FMT_CAPTURE=1 to benchmark formatting on a real workload.
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "fmt/args.h"
+#include "fmt/format.h"
+
+namespace {
+
+struct record {
+  std::string fmt;
+  fmt::dynamic_format_arg_store<fmt::format_context> args;
+};
+
+class trace_reader {
+ private:
+  std::string data_;
+  size_t pos_ = 0;
+
+  // Reads a `<size>:<text>\n` field.
+  auto read_string(std::string& text) -> bool {
+    char* end = nullptr;
+    auto size = std::strtoull(data_.c_str() + pos_, &end, 10);
+    pos_ = static_cast<size_t>(end - data_.c_str());
+    if (pos_ >= data_.size() || data_[pos_] != ':' ||
+        size > data_.size() - pos_ - 2 || data_[pos_ + 1 + size] != '\n') {
+      return false;
+    }
+    text.assign(data_, pos_ + 1, size);
+    pos_ += size + 2;
+    return true;
+  }
+
+ public:
+  auto open(const char* filename) -> bool {
+    FILE* f = std::fopen(filename, "rb");
+    if (!f) return false;
+    char buf[65536];
+    while (size_t n = std::fread(buf, 1, sizeof(buf), f)) data_.append(buf, n);
+    std::fclose(f);
+    // Version 1 traces don't have names of named arguments.
+    for (auto header : {fmt::string_view("fmt-capture 2\n"),
+                        fmt::string_view("fmt-capture 1\n")}) {
+      if (data_.compare(0, header.size(), header.data(), header.size()) == 0) {
+        pos_ = header.size();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  auto done() const -> bool { return pos_ >= data_.size(); }
+
+  // Adds an argument, named if `name` is not empty, to `args`.
+  template <typename T>
+  static void add(fmt::dynamic_format_arg_store<fmt::format_context>& args,
+                  const std::string& name, const T& value) {
+    if (name.empty())
+      args.push_back(value);
+    else
+      args.push_back(fmt::arg(name.c_str(), value));
+  }
+
+  static auto add_arg(fmt::dynamic_format_arg_store<fmt::format_context>& args,
+                      char type, const std::string& name,
+                      const std::string& value) -> bool {
+    const char* s = value.c_str();
+    switch (type) {
+    case 'i':
+      add(args, name, static_cast<int>(std::strtol(s, nullptr, 10)));
+      break;
+    case 'u':
+      add(args, name, static_cast<unsigned>(std::strtoul(s, nullptr, 10)));
+      break;
+    case 'l':
+    case 'n':  // 128-bit integers are replayed as 64-bit ones.
+      add(args, name, std::strtoll(s, nullptr, 10));
+      break;
+    case 'm':
+    case 'o':
+      add(args, name, std::strtoull(s, nullptr, 10));
+      break;
+    case 'b':
+      add(args, name, value == "true");
+      break;
+    case 'c':
+      add(args, name, value.empty() ? '\0' : value[0]);
+      break;
+    case 'f':
+      add(args, name, std::strtof(s, nullptr));
+      break;
+    case 'd':
+      add(args, name, std::strtod(s, nullptr));
+      break;
+    case 'e':
+      add(args, name, std::strtold(s, nullptr));
+      break;
+    case 'p':
+      add(args, name,
+          reinterpret_cast<const void*>(
+              static_cast<uintptr_t>(std::strtoull(s, nullptr, 16))));
+      break;
+    case 'z':
+    case 's':
+    case 'x':  // Values of user-defined types are replayed as strings.
+      add(args, name, value);
+      break;
+    default:
+      return false;
+    }
+    return true;
+  }
+
+  // Reads a record and adds its arguments to `r.args`.
+  auto read(record& r) -> bool {
+    char* end = nullptr;
+    auto num_args = std::strtoul(data_.c_str() + pos_, &end, 10);
+    pos_ = static_cast<size_t>(end - data_.c_str());
+    if (pos_ >= data_.size() || data_[pos_++] != ' ') return false;
+    if (!read_string(r.fmt)) return false;
+    auto name = std::string(), value = std::string();
+    for (unsigned long i = 0; i < num_args; ++i) {
+      name.clear();
+      if (data_.compare(pos_, 2, "= ") == 0) {
+        pos_ += 2;
+        if (!read_string(name)) return false;
+      }
+      if (pos_ + 2 > data_.size() || data_[pos_ + 1] != ' ') return false;
+      char type = data_[pos_];
+      pos_ += 2;
+      if (!read_string(value)) return false;
+      if (!add_arg(r.args, type, name, value)) return false;
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argv[1][0] == '-') {
+    fmt::print(stderr, "usage: {} <trace> [benchmark options]\n", argv[0]);
+    return 1;
+  }
+  const char* trace = argv[1];
+  auto opts = bench::options();
+  argv[1] = argv[0];
+  if (!bench::parse_options(argc - 1, argv + 1, opts)) return 1;
+
+  auto reader = trace_reader();
+  if (!reader.open(trace)) {
+    fmt::print(stderr, "cannot read trace {}\n", trace);
+    return 1;
+  }
+  auto records = std::vector<std::unique_ptr<record>>();
+  size_t skipped = 0, bytes = 0;
+  auto buf = fmt::memory_buffer();
+  while (!reader.done()) {
+    auto r = std::unique_ptr<record>(new record());
+    if (!reader.read(*r)) {
+      fmt::print(stderr, "invalid record {} in {}\n", records.size(), trace);
+      return 1;
+    }
+    // Skip records that can't be replayed, e.g. because a user-defined type
+    // has a format spec that is not valid for strings.
+    buf.clear();
+    FMT_TRY { fmt::vformat_to(fmt::appender(buf), r->fmt, r->args); }
+    FMT_CATCH(const fmt::format_error&) {
+      ++skipped;
+      continue;
+    }
+    bytes += buf.size();
+    records.push_back(std::move(r));
+  }
+  fmt::print(stderr, "{} records, {} skipped, {} bytes per pass\n",
+             records.size(), skipped, bytes);
+  if (records.empty()) return 1;
+
+  bench::runner runner(opts);
+  runner.run("replay", [&] {
+    for (const auto& r : records) {
+      buf.clear();
+      fmt::vformat_to(fmt::appender(buf), r->fmt, r->args);
+      bench::do_not_optimize(buf.data());
+    }
+  });
+  for (const bench::result& result : runner.results()) {
+    double seconds = result.median_ns * 1e-9;
+    fmt::print(stderr, "{:.0f} calls/s, {:.1f} MB/s\n",
+               static_cast<double>(records.size()) / seconds,
+               static_cast<double>(bytes) / seconds * 1e-6);
+  }
+  return runner.finish();
+}
@@ -0,0 +1,82 @@
+// Formatting library for C++ - capture tests
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+
+#include <cstdio>
+#include <string>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+static_assert(FMT_CAPTURE, "capture-test must be compiled with FMT_CAPTURE=1");
+
+namespace {
+const char* trace_file = "capture-test.trace";
+
+auto read_trace() -> std::string {
+  auto result = std::string();
+  FILE* f = std::fopen(trace_file, "rb");
+  if (!f) return result;
+  char buf[4096];
+  while (size_t n = std::fread(buf, 1, sizeof(buf), f)) result.append(buf, n);
+  std::fclose(f);
+  std::remove(trace_file);
+  return result;
+}
+
+struct point {
+  int x, y;
+};
+}  // namespace
+
+template <> struct fmt::formatter<point> : formatter<std::string> {
+  auto format(point p, format_context& ctx) const
+      -> decltype(ctx.out()) {
+    // The nested call shouldn't be captured.
+    return formatter<std::string>::format(fmt::format("({}, {})", p.x, p.y),
+                                          ctx);
+  }
+};
+
+TEST(capture_test, record) {
+  fmt::start_capture(trace_file);
+  EXPECT_EQ(fmt::format("{} {}", 42, "abc"), "42 abc");
+  EXPECT_EQ(fmt::format("{:.1f}\n{}", 1.5, point{1, 2}), "1.5\n(1, 2)");
+  EXPECT_EQ(fmt::format("{}{}{}", true, 'x', std::string("str")), "truexstr");
+  EXPECT_EQ(fmt::format("no args"), "no args");
+  fmt::stop_capture();
+  EXPECT_EQ(fmt::format("{}", "not captured"), "not captured");
+  EXPECT_EQ(read_trace(),
+            "fmt-capture 2\n"
+            "2 5:{} {}\ni 2:42\nz 3:abc\n"
+            "2 9:{:.1f}\n{}\nd 3:1.5\nx 6:(1, 2)\n"
+            "3 6:{}{}{}\nb 4:true\nc 1:x\ns 3:str\n"
+            "0 7:no args\n");
+}
+
+TEST(capture_test, named_args) {
+  fmt::start_capture(trace_file);
+  // Only names referenced in the format string are recorded.
+  EXPECT_EQ(fmt::format("{}{x}{{y}}{x:{w}}", 2, fmt::arg("x", 1),
+                        fmt::arg("w", 3), fmt::arg("u", 4)),
+            "21{y}  1");
+  fmt::stop_capture();
+  EXPECT_EQ(read_trace(),
+            "fmt-capture 2\n"
+            "4 17:{}{x}{{y}}{x:{w}}\n"
+            "i 1:2\n= 1:x\ni 1:1\n= 1:w\ni 1:3\ni 1:4\n");
+}
+
+TEST(capture_test, sampling) {
+  fmt::start_capture(trace_file, 3, 2);
+  for (int i = 0; i < 10; ++i) (void)fmt::format("{}", i);
+  fmt::stop_capture();
+  EXPECT_EQ(read_trace(), "fmt-capture 2\n1 2:{}\ni 1:0\n1 2:{}\ni 1:3\n");
+}
+
+TEST(capture_test, open_error) {
+  EXPECT_THROW(fmt::start_capture("nonexistent-dir/trace"), std::system_error);
+}
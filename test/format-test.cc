@@ -20,9 +20,11 @@
 #include <cmath>               // std::signbit
 #include <condition_variable>  // std::condition_variable
 #include <cstring>             // std::strlen
+#include <deque>               // std::deque
 #include <iterator>            // std::back_inserter
 #include <list>                // std::list
 #include <mutex>               // std::mutex
+#include <random>              // std::mt19937_64
 #include <string>              // std::string
 #include <thread>              // std::thread
 #include <type_traits>         // std::is_default_constructible
@@ -301,6 +303,62 @@ TEST(util_test, report_system_error) {
                to_string(out));
 }
 
+TEST(util_test, simd_kernels) {
+  using fmt::detail::simd_level;
+  auto find_escape = [](const char* begin, const char* end) {
+    for (; begin != end; ++begin) {
+      auto c = static_cast<unsigned char>(*begin);
+      if (c < 0x20 || c == '"' || c == '\\' || c >= 0x7f) break;
+    }
+    return begin;
+  };
+  auto find_non_ascii = [](const char* begin, const char* end) {
+    while (begin != end && static_cast<unsigned char>(*begin) < 0x80) ++begin;
+    return begin;
+  };
+  auto find_brace = [](const char* begin, const char* end) {
+    while (begin != end && *begin != '{' && *begin != '}') ++begin;
+    return begin;
+  };
+  const char specials[] = {'\0', '\n', '"', '\\', '\x7f', '\x80', '\xff',
+                           '{',  '}'};
+  for (auto level : {simd_level::generic, simd_level::sse2, simd_level::avx2,
+                     simd_level::avx512}) {
+    auto kernels = fmt::detail::select_simd_kernels(level);
+    EXPECT_LE(kernels.level, level);
+    // Place a special char at every position of strings of different sizes
+    // to cover the vector loops and the scalar tails.
+    for (size_t size = 0; size <= 200; size += 7) {
+      auto s = std::string(size, 'a');
+      const char* begin = s.data();
+      const char* end = begin + size;
+      EXPECT_EQ(kernels.find_escape(begin, end), end);
+      EXPECT_EQ(kernels.find_non_ascii(begin, end), end);
+      EXPECT_EQ(kernels.find_brace(begin, end), end);
+      for (size_t i = 0; i < size; ++i) {
+        for (char c : specials) {
+          s[i] = c;
+          EXPECT_EQ(kernels.find_escape(begin, end), find_escape(begin, end));
+          EXPECT_EQ(kernels.find_non_ascii(begin, end),
+                    find_non_ascii(begin, end));
+          EXPECT_EQ(kernels.find_brace(begin, end), find_brace(begin, end));
+        }
+        s[i] = 'a';
+      }
+    }
+  }
+}
+
+TEST(util_test, cpu_features) {
+  auto info = fmt::cpu_features();
+  EXPECT_NE(info.kernels, nullptr);
+  auto kernels = fmt::string_view(info.kernels);
+  if (info.avx512bw) EXPECT_TRUE(info.avx2);
+  if (kernels == "avx512") EXPECT_TRUE(info.avx512bw);
+  if (kernels == "avx2") EXPECT_TRUE(info.avx2);
+  if (kernels == "sse2") EXPECT_TRUE(info.sse2);
+}
+
 TEST(memory_buffer_test, ctor) {
   basic_memory_buffer<char, 123> buffer;
   EXPECT_EQ(static_cast<size_t>(0), buffer.size());
@@ -556,6 +614,17 @@ TEST(format_test, escape) {
   EXPECT_EQ(fmt::format("{{{0}}}", 42), "{42}");
 }
 
+TEST(format_test, long_format_string) {
+  auto text = std::string(100, 'x');
+  EXPECT_EQ(fmt::format(runtime(text + "{}" + text + "{{}}" + text), 42),
+            text + "42" + text + "{}" + text);
+  EXPECT_EQ(fmt::format(runtime(text + "{}"), 42), text + "42");
+  EXPECT_THROW_MSG((void)fmt::format(runtime(text + "}" + text)),
+                   format_error, "unmatched '}' in format string");
+  EXPECT_THROW_MSG((void)fmt::format(runtime(text + "}")), format_error,
+                   "unmatched '}' in format string");
+}
+
 TEST(format_test, unmatched_braces) {
   EXPECT_THROW_MSG((void)fmt::format(runtime("{")), format_error,
                    "invalid format string");
@@ -604,6 +673,12 @@ TEST(format_test, arg_errors) {
 
 TEST(format_test, display_width_precision) {
   EXPECT_EQ(fmt::format("{:.5}", "🐱🐱🐱"), "🐱🐱");
+  auto ascii = std::string(40, 'a');
+  EXPECT_EQ(fmt::format("{:.45}", ascii + "🐱🐱🐱"), ascii + "🐱🐱");
+  EXPECT_EQ(fmt::format("{:.35}", ascii + "🐱"), std::string(35, 'a'));
+  EXPECT_EQ(fmt::format("{:>44}", ascii + "🐱"), "  " + ascii + "🐱");
+  EXPECT_EQ(fmt::format("{:?}", ascii + "\n" + ascii),
+            '"' + ascii + "\\n" + ascii + '"');
 }
 
 template <int N> struct test_format {
@@ -1979,6 +2054,124 @@ TEST(format_test, group_digits_view) {
   EXPECT_EQ(fmt::format("{}", fmt::group_digits(-10000000)), "-10,000,000");
   EXPECT_EQ(fmt::format("{:8}", fmt::group_digits(-1000)), "  -1,000");
   EXPECT_EQ(fmt::format("{:8}", fmt::group_digits(-100)), "    -100");
+  EXPECT_EQ(fmt::format("{}", fmt::group_digits(0)), "0");
+  EXPECT_EQ(fmt::format("{}", fmt::group_digits(999)), "999");
+  EXPECT_EQ(fmt::format("{}", fmt::group_digits(100200)), "100,200");
+  EXPECT_EQ(fmt::format("{:+}", fmt::group_digits(1000)), "+1,000");
+  EXPECT_EQ(fmt::format("{:<8}|", fmt::group_digits(1000)), "1,000   |");
+  EXPECT_EQ(fmt::format("{}", fmt::group_digits(max_value<uint64_t>())),
+            "18,446,744,073,709,551,615");
+  EXPECT_EQ(
+      fmt::format("{}", fmt::group_digits(std::numeric_limits<int64_t>::min())),
+      "-9,223,372,036,854,775,808");
+  EXPECT_EQ(fmt::format("{:x}", fmt::group_digits(0x123456)), "123,456");
+  auto s = std::string();
+  fmt::format_to(std::back_inserter(s), "{:>12}", fmt::group_digits(1234567));
+  EXPECT_EQ(s, "   1,234,567");
+  char buf[5];
+  auto result = fmt::format_to_n(buf, sizeof(buf), "{}",
+                                 fmt::group_digits(1234567));
+  EXPECT_EQ(result.size, 9);
+  EXPECT_EQ(fmt::string_view(buf, sizeof(buf)), "1,234");
+}
+
+// Returns 10^n as an array of limbs.
+auto pow10_limbs(size_t n) -> std::vector<uint64_t> {
+  auto limbs = std::vector<uint64_t>{1};
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t carry = 0;
+    for (auto& limb : limbs) {
+      auto lo = (limb & 0xffffffff) * 10 + carry;
+      auto hi = (limb >> 32) * 10 + (lo >> 32);
+      limb = (hi << 32) | (lo & 0xffffffff);
+      carry = hi >> 32;
+    }
+    if (carry != 0) limbs.push_back(carry);
+  }
+  return limbs;
+}
+
+// Parses a decimal string into limbs with schoolbook arithmetic.
+auto parse_limbs(const std::string& s) -> std::vector<uint64_t> {
+  auto limbs = std::vector<uint64_t>();
+  for (size_t i = 0; i < s.size();) {
+    size_t n = std::min<size_t>(s.size() - i, 9);
+    uint64_t mul = 1, carry = 0;
+    for (size_t j = 0; j < n; ++j, ++i) {
+      mul *= 10;
+      carry = carry * 10 + static_cast<uint64_t>(s[i] - '0');
+    }
+    for (auto& limb : limbs) {
+      auto lo = (limb & 0xffffffff) * mul + carry;
+      auto hi = (limb >> 32) * mul + (lo >> 32);
+      limb = (hi << 32) | (lo & 0xffffffff);
+      carry = hi >> 32;
+    }
+    if (carry != 0) limbs.push_back(carry);
+  }
+  return limbs;
+}
+
+TEST(format_test, bigint_view) {
+  uint64_t zero[] = {0, 0};
+  EXPECT_EQ(fmt::format("{}", fmt::bigint_view(zero, 0)), "0");
+  EXPECT_EQ(fmt::format("{}", fmt::bigint_view(zero, 2, true)), "0");
+  uint64_t one[] = {1};
+  EXPECT_EQ(fmt::format("{}", fmt::bigint_view(one, 1, true)), "-1");
+  uint64_t pow64[] = {0, 1};
+  auto n = fmt::bigint_view(pow64, 2);
+  EXPECT_EQ(fmt::format("{}", n), "18446744073709551616");
+  EXPECT_EQ(fmt::format("{:+}", n), "+18446744073709551616");
+  EXPECT_EQ(fmt::format("{:x}", n), "10000000000000000");
+  EXPECT_EQ(fmt::format("{:#X}", fmt::bigint_view(pow64, 2, true)),
+            "-0X10000000000000000");
+  EXPECT_EQ(fmt::format("{:#o}", n), "02000000000000000000000");
+  EXPECT_EQ(fmt::format("{:b}", n), "1" + std::string(64, '0'));
+  EXPECT_EQ(fmt::format("{:>24}", n), "    18446744073709551616");
+  EXPECT_EQ(fmt::format("{:024}", fmt::bigint_view(pow64, 2, true)),
+            "-00018446744073709551616");
+  EXPECT_EQ(fmt::format("{}", fmt::group_digits(n)),
+            "18,446,744,073,709,551,616");
+  EXPECT_EQ(fmt::format("{:>28}", fmt::group_digits(n)),
+            "  18,446,744,073,709,551,616");
+  uint64_t max128[] = {~uint64_t(), ~uint64_t()};
+  EXPECT_EQ(fmt::format("{}", fmt::bigint_view(max128, 2)),
+            "340282366920938463463374607431768211455");
+  EXPECT_EQ(fmt::format("{:o}", fmt::bigint_view(max128, 2)),
+            "3" + std::string(42, '7'));
+  EXPECT_THROW_MSG((void)fmt::format(fmt::runtime("{:c}"), n), format_error,
+                   "invalid format specifier");
+  EXPECT_THROW_MSG((void)fmt::format(fmt::runtime("{:L}"), n), format_error,
+                   "invalid format specifier");
+
+  // Large numbers are converted with divide and conquer.
+  for (size_t digits : {19, 100, 1000, 2000, 5000, 20000}) {
+    auto limbs = pow10_limbs(digits);
+    EXPECT_EQ(fmt::format("{}", fmt::bigint_view(limbs)),
+              "1" + std::string(digits, '0'));
+    // 10^n - 1
+    for (auto& limb : limbs) {
+      if (limb-- != 0) break;
+    }
+    EXPECT_EQ(fmt::format("{}", fmt::bigint_view(limbs)),
+              std::string(digits, '9'));
+  }
+
+  // Irregular values above the basecase threshold exercise the Barrett,
+  // Karatsuba and long division paths. Runs of zero and all-ones limbs hit
+  // the quotient correction and borrow propagation corner cases.
+  auto rng = std::mt19937_64(42);
+  for (size_t size : {97, 150, 257, 600, 1500, 3000}) {
+    auto limbs = std::vector<uint64_t>(size);
+    for (auto& limb : limbs) {
+      auto r = rng();
+      limb = r % 8 == 0 ? 0 : r % 8 == 1 ? ~uint64_t() : rng();
+    }
+    limbs.back() |= 1;
+    auto s = fmt::format("{}", fmt::bigint_view(limbs));
+    ASSERT_NE(s[0], '0');
+    EXPECT_EQ(parse_limbs(s), limbs) << "size " << size;
+  }
 }
 
 #ifdef __cpp_generic_lambdas
@@ -1999,9 +2192,116 @@ FMT_END_NAMESPACE
 
 TEST(format_test, nested_formatter) {
   EXPECT_EQ(fmt::format("{:>16.2f}", point{1, 2}), "    (1.00, 2.00)");
+  EXPECT_EQ(fmt::format("{:*^15.1f}", point{1, 2}), "**(1.0, 2.0)***");
+  EXPECT_EQ(fmt::format("{:\u00f6<13.1f}|", point{1, 2}),
+            "(1.0, 2.0)\u00f6\u00f6\u00f6|");
+  EXPECT_EQ(fmt::format("{:4}", point{1, 2}), "(1, 2)");
+
+  // Padding of output that doesn't fit into the reserved buffer space.
+  auto s = fmt::format("{:>600.200f}", point{1, 2});
+  EXPECT_EQ(s.size(), 600);
+  EXPECT_EQ(s.substr(0, 600 - 2 * 202 - 4), std::string(192, ' '));
+  EXPECT_EQ(s.back(), ')');
+
+  // Padding after the content of a partially filled buffer.
+  auto buf = fmt::memory_buffer();
+  auto expected = std::string();
+  for (int i = 0; i < 100; ++i) {
+    fmt::format_to(fmt::appender(buf), "{:>12}", point{1, 2});
+    expected += "      (1, 2)";
+  }
+  EXPECT_EQ(fmt::to_string(buf), expected);
+
+  char out[20];
+  auto result = fmt::format_to_n(out, sizeof(out), "{:>12}|{:<12}", point{1, 2},
+                                 point{3, 4});
+  EXPECT_EQ(result.size, 25);
+  EXPECT_EQ(fmt::string_view(out, sizeof(out)), "      (1, 2)|(3, 4) ");
+}
+
+struct label {
+  const char* text;
+};
+
+FMT_BEGIN_NAMESPACE
+template <> struct formatter<label> {
+  format_specs specs;
+
+  FMT_CONSTEXPR auto parse(format_parse_context& ctx) -> const char* {
+    specs.width = 9;
+    specs.set_fill('*');
+    specs.set_align(align::center);
+    return ctx.begin();
+  }
+
+  auto format(label l, format_context& ctx) const -> decltype(ctx.out()) {
+    return format_padded(
+        ctx, specs,
+        [l](auto out) -> decltype(out) {
+          return fmt::format_to(out, "<{}>", l.text);
+        },
+        std::strlen(l.text) + 2);
+  }
+};
+FMT_END_NAMESPACE
+
+TEST(format_test, format_padded) {
+  EXPECT_EQ(fmt::format("{}", label{"abc"}), "**<abc>**");
+  EXPECT_EQ(fmt::format("{}", label{"abcdefgh"}), "<abcdefgh>");
+  char out[6];
+  auto result = fmt::format_to_n(out, sizeof(out), "{}", label{"a"});
+  EXPECT_EQ(result.size, 9);
+  EXPECT_EQ(fmt::string_view(out, sizeof(out)), "***<a>");
 }
 #endif  // __cpp_generic_lambdas
 
+struct hex_id {
+  uint64_t value;
+};
+
+FMT_BEGIN_NAMESPACE
+template <> struct formatter<hex_id> {
+  FMT_CONSTEXPR auto parse(format_parse_context& ctx) -> const char* {
+    return ctx.begin();
+  }
+
+  auto format(hex_id id, format_context& ctx) const -> appender {
+    char* p = ctx.reserve(16);
+    if (!p) return fmt::format_to(ctx.out(), "{:016x}", id.value);
+    for (int i = 15; i >= 0; --i, id.value >>= 4)
+      p[i] = "0123456789abcdef"[id.value & 0xf];
+    ctx.commit(p + 16);
+    return ctx.out();
+  }
+};
+FMT_END_NAMESPACE
+
+TEST(format_test, reserve_output) {
+  auto id = hex_id{0x0123456789abcdef};
+  EXPECT_EQ(fmt::format("{}", id), "0123456789abcdef");
+  EXPECT_EQ(fmt::format("[{}|{}]", id, hex_id{42}),
+            "[0123456789abcdef|000000000000002a]");
+
+  // Output to a flushing buffer.
+  auto s = std::string();
+  auto expected = std::string();
+  for (int i = 0; i < 100; ++i) {
+    fmt::format_to(std::back_inserter(s), "{}{}", i, id);
+    expected += std::to_string(i) + "0123456789abcdef";
+  }
+  EXPECT_EQ(s, expected);
+  auto list = std::list<char>();
+  fmt::format_to(std::back_inserter(list), "{}{}", id, id);
+  EXPECT_EQ(std::string(list.begin(), list.end()),
+            "0123456789abcdef0123456789abcdef");
+
+  // Output to a buffer of limited size.
+  char buf[10];
+  auto result = fmt::format_to_n(buf, sizeof(buf), "{}", id);
+  EXPECT_EQ(result.size, 16);
+  EXPECT_EQ(fmt::string_view(buf, sizeof(buf)), "0123456789");
+}
+
 enum test_enum { foo, bar };
 auto format_as(test_enum e) -> int { return e; }
 
@@ -2177,6 +2477,67 @@ TEST(format_test, formatted_size) {
   EXPECT_EQ(2u, fmt::formatted_size(std::locale(), "{}", 42));
 }
 
+TEST(format_test, hashers) {
+  auto fnv1a = [](fmt::string_view s) {
+    auto h = fmt::fnv1a_hasher();
+    h.update(s.data(), s.size());
+    return h.digest();
+  };
+  EXPECT_EQ(fnv1a(""), 0xcbf29ce484222325);
+  EXPECT_EQ(fnv1a("a"), 0xaf63dc4c8601ec8c);
+  EXPECT_EQ(fnv1a("foobar"), 0x85944171f73967e8);
+
+  auto xxh64 = [](fmt::string_view s, uint64_t seed) {
+    auto h = fmt::xxhash64_hasher(seed);
+    h.update(s.data(), s.size());
+    return h.digest();
+  };
+  EXPECT_EQ(xxh64("", 0), 0xef46db3751d8e999);
+  EXPECT_EQ(xxh64("abc", 0), 0x44bc2cf5ad770999);
+  EXPECT_EQ(xxh64("xxhash", 20141025), 0xb559b98d844e0635);
+  auto text = std::string("Nobody inspects the spammish repetition");
+  EXPECT_EQ(xxh64(text, 0), 0xfbcea83c8a378bf1);
+  // The result doesn't depend on how the input is split.
+  for (size_t chunk = 1; chunk <= text.size(); ++chunk) {
+    auto h = fmt::xxhash64_hasher();
+    for (size_t i = 0; i < text.size(); i += chunk)
+      h.update(text.data() + i, std::min(chunk, text.size() - i));
+    EXPECT_EQ(h.digest(), 0xfbcea83c8a378bf1);
+  }
+}
+
+struct size_hasher {
+  size_t size = 0;
+  int updates = 0;
+
+  void update(const char*, size_t n) {
+    size += n;
+    ++updates;
+  }
+  auto digest() const -> std::pair<size_t, int> { return {size, updates}; }
+};
+
+TEST(format_test, format_hash) {
+  EXPECT_EQ(fmt::format_hash("{}", "foobar"), 0x85944171f73967e8);
+  EXPECT_EQ(fmt::format_hash<fmt::xxhash64_hasher>("{}{}", "xx", "hash"),
+            0x32dd38952c4bc720);
+
+  // Long output is streamed through the buffer in chunks.
+  auto s = std::string();
+  for (int i = 0; i < 1000; ++i) s += std::to_string(i);
+  EXPECT_EQ(s.size(), 2890u);
+  EXPECT_EQ(fmt::format_hash("{}", s), 0x194bfd620ea9212f);
+  EXPECT_EQ(fmt::format_hash<fmt::xxhash64_hasher>("{}", s),
+            0xea2e44efe1610077);
+  EXPECT_EQ(fmt::format_hash<fmt::xxhash64_hasher>("{:>3000}", s),
+            fmt::format_hash<fmt::xxhash64_hasher>(
+                "{}", fmt::format("{:>3000}", s)));
+
+  auto result = fmt::format_hash<size_hasher>("{:1000}", "");
+  EXPECT_EQ(result.first, 1000u);
+  EXPECT_EQ(result.second, 4);
+}
+
 TEST(format_test, format_to_no_args) {
   std::string s;
   fmt::format_to(std::back_inserter(s), "test");
@@ -2203,6 +2564,55 @@ TEST(format_test, format_to_vector) {
   EXPECT_EQ(string_view(v.data(), v.size()), "foo");
 }
 
+TEST(format_test, format_to_deque) {
+  auto d = std::deque<char>();
+  fmt::format_to(std::back_inserter(d), "{:>1000}", 42);
+  EXPECT_EQ(std::string(d.begin(), d.end()), std::string(998, ' ') + "42");
+}
+
+namespace test_ns {
+struct chunk_iterator {
+  std::string* out;
+  int* num_chunks;
+
+  using iterator_category = std::output_iterator_tag;
+  using value_type = void;
+  using difference_type = void;
+  using pointer = void;
+  using reference = void;
+
+  auto operator++() -> chunk_iterator& { return *this; }
+  auto operator++(int) -> chunk_iterator { return *this; }
+  auto operator*() -> chunk_iterator& { return *this; }
+  auto operator=(char c) -> chunk_iterator& {
+    out->push_back(c);
+    return *this;
+  }
+};
+
+auto bulk_append(chunk_iterator it, const char* data, size_t size)
+    -> chunk_iterator {
+  it.out->append(data, size);
+  ++*it.num_chunks;
+  return it;
+}
+}  // namespace test_ns
+
+TEST(format_test, format_to_bulk_append) {
+  auto s = std::string();
+  int num_chunks = 0;
+  auto it = test_ns::chunk_iterator{&s, &num_chunks};
+  fmt::format_to(it, "{:>1000}", 42);
+  EXPECT_EQ(s, std::string(998, ' ') + "42");
+  EXPECT_EQ(num_chunks, (1000 + FMT_ITERATOR_BUFFER_SIZE - 1) /
+                            FMT_ITERATOR_BUFFER_SIZE);
+
+  s.clear();
+  auto result = fmt::format_to_n(it, 5, "{}", 1234567);
+  EXPECT_EQ(result.size, 7);
+  EXPECT_EQ(s, "12345");
+}
+
 struct nongrowing_container {
   using value_type = char;
   void push_back(char) { throw std::runtime_error("can't take it any more"); }
@@ -0,0 +1,132 @@
+// A fuzzer for pathological performance, e.g. super-linear formatting time.
+// For the license information refer to format.h.
+//
+// Unlike the other fuzzers that look for crashes, this one measures the time
+// of each formatting call and aborts if it exceeds a budget proportional to
+// the size of the input and output. The output is counted rather than stored
+// so that large widths and precisions don't hit the FMT_FUZZ allocation
+// limit. The budget can be changed with the FMT_FUZZ_NS_PER_BYTE environment
+// variable. Findings should be minimized and added as regression cases to the
+// "pathological" benchmarks in test/bench/fmt-bench.cc.
+
+#include <fmt/args.h>
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+#include "fuzzer-common.h"
+
+namespace {
+
+// Time allowed per call in addition to the per-byte budget. It absorbs
+// page faults and preemption.
+constexpr double base_budget_ns = 1e6;
+
+auto ns_per_byte() -> double {
+  static double value = [] {
+    const char* s = std::getenv("FMT_FUZZ_NS_PER_BYTE");
+    return s ? std::atof(s) : 100.0;
+  }();
+  return value;
+}
+
+// Returns the time in nanoseconds to format args with format_str and sets
+// output_size to the size of the output.
+auto measure(fmt::string_view format_str, fmt::format_args args,
+             size_t& output_size) -> double {
+  auto start = std::chrono::steady_clock::now();
+  auto buf = fmt::detail::counting_buffer<>();
+  try {
+    fmt::detail::vformat_to(buf, format_str, args, {});
+  } catch (std::exception&) {
+  }
+  output_size = buf.count();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+void check(fmt::string_view format_str, fmt::format_args args) {
+  size_t output_size = 0;
+  auto budget = [&] {
+    return base_budget_ns +
+           ns_per_byte() * static_cast<double>(format_str.size() + output_size);
+  };
+  if (measure(format_str, args, output_size) <= budget()) return;
+  // Measure again to filter out noise.
+  double ns = measure(format_str, args, output_size);
+  if (ns <= budget()) return;
+  std::fprintf(stderr,
+               "formatting took %.0f ns for %zu input and %zu output bytes "
+               "(%.1f ns/byte)\n",
+               ns, format_str.size(), output_size,
+               ns / static_cast<double>(format_str.size() + output_size));
+  std::abort();
+}
+
+template <typename T> void invoke_fmt(const uint8_t* data, size_t size) {
+  static_assert(sizeof(T) <= fixed_size, "fixed_size is too small");
+  if (size <= fixed_size) return;
+  auto value = assign_from_buf<T>(data);
+  data_to_string format_str(data + fixed_size, size - fixed_size);
+  // The value is passed twice to allow dynamic width and precision.
+  check(format_str.get(), fmt::make_format_args(value, value));
+}
+
+void invoke_string(const uint8_t* data, size_t size) {
+  if (size <= fixed_size) return;
+  auto value = std::string(as_chars(data), fixed_size);
+  data_to_string format_str(data + fixed_size, size - fixed_size);
+  auto width = assign_from_buf<unsigned short>(data);
+  check(format_str.get(), fmt::make_format_args(value, width));
+}
+
+// Formats with a long list of named arguments "a0", "a1", ... whose number
+// is given by the first byte.
+void invoke_named_args(const uint8_t* data, size_t size) {
+  if (size <= 1) return;
+  auto store = fmt::dynamic_format_arg_store<fmt::format_context>();
+  for (int i = 0, n = data[0] + 1; i < n; ++i)
+    store.push_back(fmt::arg(fmt::format("a{}", i).c_str(), i));
+  data_to_string format_str(data + 1, size - 1);
+  check(format_str.get(), store);
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size <= 3) return 0;
+
+  const auto first = data[0];
+  data++;
+  size--;
+
+  switch (first) {
+  case 0:
+    invoke_fmt<int>(data, size);
+    break;
+  case 1:
+    invoke_fmt<unsigned long long>(data, size);
+    break;
+  case 2:
+    invoke_fmt<float>(data, size);
+    break;
+  case 3:
+    invoke_fmt<double>(data, size);
+    break;
+  case 4:
+    invoke_fmt<long double>(data, size);
+    break;
+  case 5:
+    invoke_string(data, size);
+    break;
+  case 6:
+    invoke_named_args(data, size);
+    break;
+  }
+  return 0;
+}
@@ -319,6 +319,162 @@ TEST(ostream_test, flush) {
   EXPECT_READ(in, "x");
 }
 
+#  ifndef _WIN32
+TEST(ostream_test, nonblocking) {
+  auto p = fmt::pipe();
+  int fd = p.write_end.descriptor();
+  ASSERT_EQ(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK), 0);
+  auto out = fmt::output_file(std::move(p.write_end), fmt::buffer_size = 1000,
+                              fmt::nonblocking);
+  auto line = std::string(99, 'x') + '\n';
+  auto expected = std::string();
+  // Write until the pipe is full and then some more without blocking.
+  while (!out.want_write()) {
+    out.print("{}", line);
+    expected += line;
+  }
+  for (int i = 0; i < 1000; ++i) {
+    out.print("{}", line);
+    expected += line;
+  }
+  EXPECT_FALSE(out.try_flush());
+  EXPECT_GT(out.pending_bytes(), 100000u);
+  auto result = std::string();
+  char buf[4096];
+  while (result.size() < expected.size()) {
+    out.try_flush();
+    result.append(buf, p.read_end.read(buf, sizeof(buf)));
+  }
+  EXPECT_EQ(result, expected);
+  EXPECT_TRUE(out.try_flush());
+  EXPECT_FALSE(out.want_write());
+  EXPECT_EQ(out.pending_bytes(), 0u);
+}
+#  endif
+
+static auto read_input_file(const std::string& path) -> std::string {
+  auto in = fmt::input_file(path);
+  auto result = std::string();
+  char buf[1000];
+  while (size_t n = in.read(buf, sizeof(buf))) result.append(buf, n);
+  return result;
+}
+
+TEST(ostream_test, compress) {
+  auto test_file = uniq_file_name(__LINE__);
+  auto expected = std::string();
+  {
+    auto out = fmt::output_file(test_file, fmt::buffer_size = 4096,
+                                fmt::compress = fmt::compression::fast);
+    for (int i = 0; i < 10000; ++i) {
+      auto s = fmt::format("record {} {}\n", i, i % 7 == 0 ? "x" : "yyyyyyyy");
+      out.print("{}", s);
+      expected += s;
+    }
+    out.print("{:z>100000}", "");
+    expected += std::string(100000, 'z');
+  }
+  auto f = file(test_file, file::RDONLY);
+  EXPECT_LT(f.size(), static_cast<long long>(expected.size() / 4));
+  EXPECT_EQ(read_input_file(test_file), expected);
+}
+
+#  ifndef _WIN32
+TEST(ostream_test, compress_nonblocking) {
+  auto p = fmt::pipe();
+  int fd = p.write_end.descriptor();
+  ASSERT_EQ(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK), 0);
+  auto out = fmt::output_file(std::move(p.write_end), fmt::buffer_size = 1000,
+                              fmt::compress = fmt::compression::fast,
+                              fmt::nonblocking);
+  auto expected = std::string();
+  uint64_t x = 0;
+  auto print_record = [&](int i) {
+    // Pseudo-random records so that the compressed output fills the pipe.
+    x = x * 6364136223846793005 + 1442695040888963407;
+    auto s = fmt::format("record {} {:x}\n", i, x);
+    out.print("{}", s);
+    expected += s;
+  };
+  int i = 0;
+  while (!out.want_write()) print_record(i++);
+  for (int j = 0; j < 1000; ++j) print_record(i++);
+  EXPECT_FALSE(out.try_flush());
+
+  // Drain the pipe while the queued blocks are written.
+  auto compressed = std::string();
+  char buf[4096];
+  while (!out.try_flush())
+    compressed.append(buf, p.read_end.read(buf, sizeof(buf)));
+  EXPECT_EQ(out.pending_bytes(), 0u);
+  out.close();
+  while (size_t n = p.read_end.read(buf, sizeof(buf)))
+    compressed.append(buf, n);
+  EXPECT_LT(compressed.size(), expected.size());
+
+  auto test_file = uniq_file_name(__LINE__);
+  {
+    auto f = file(test_file, file::WRONLY | file::CREATE | file::TRUNC);
+    f.write(compressed.data(), compressed.size());
+  }
+  EXPECT_EQ(read_input_file(test_file), expected);
+}
+#  endif
+
+TEST(ostream_test, compress_incompressible) {
+  auto test_file = uniq_file_name(__LINE__);
+  auto expected = std::string();
+  uint32_t state = 42;
+  for (int i = 0; i < 100000; ++i) {
+    state = state * 1664525 + 1013904223;
+    expected += static_cast<char>(state >> 24);
+  }
+  {
+    auto out = fmt::output_file(test_file, fmt::buffer_size = 1000,
+                                fmt::compress = fmt::compression::fast);
+    out.print("{}", expected);
+  }
+  EXPECT_EQ(read_input_file(test_file), expected);
+}
+
+TEST(ostream_test, compress_append) {
+  auto test_file = uniq_file_name(__LINE__);
+  fmt::output_file(test_file, fmt::compress = fmt::compression::fast)
+      .print("Don't ");
+  int oflag = file::WRONLY | file::APPEND;
+  fmt::output_file(test_file, oflag, fmt::compress = fmt::compression::fast)
+      .print("Panic");
+  EXPECT_EQ(read_input_file(test_file), "Don't Panic");
+}
+
+TEST(input_file_test, uncompressed) {
+  auto test_file = uniq_file_name(__LINE__);
+  fmt::output_file(test_file).print("abc");
+  EXPECT_EQ(read_input_file(test_file), "abc");
+  fmt::output_file(test_file).print("{:x>10000}", "");
+  EXPECT_EQ(read_input_file(test_file), std::string(10000, 'x'));
+}
+
+TEST(input_file_test, invalid) {
+  auto test_file = uniq_file_name(__LINE__);
+  fmt::output_file(test_file, fmt::compress = fmt::compression::fast)
+      .print("{:a>1000}", "");
+  auto f = file(test_file, file::RDONLY);
+  auto data = read(f, static_cast<size_t>(f.size()));
+  auto write_file = [&](const std::string& content) {
+    auto out = file(test_file, file::WRONLY | file::TRUNC);
+    out.write(content.data(), content.size());
+  };
+  // Truncated block.
+  write_file(data.substr(0, data.size() - 1));
+  EXPECT_THROW(read_input_file(test_file), std::runtime_error);
+  // Match offset before the beginning of the block.
+  auto corrupted = data;
+  corrupted[8 + 8 + 2] = '\xff';
+  write_file(corrupted);
+  EXPECT_THROW(read_input_file(test_file), std::runtime_error);
+}
+
 TEST(file_test, default_ctor) {
   file f;
   EXPECT_EQ(-1, f.descriptor());
@@ -596,4 +752,145 @@ TEST(file_test, io_putting) {
   EXPECT_EQ(read_size, write_size);
 }
 
+#  if FMT_USE_MMAP
+TEST(flight_recorder_test, ring) {
+  const char* path = "test-flight-recorder";
+  size_t capacity = 0;
+  {
+    auto rec = fmt::flight_recorder(path, 4096, 64);
+    capacity = rec.capacity();
+    EXPECT_GT(capacity, 0u);
+    EXPECT_TRUE(fmt::read_flight_recorder(path).empty());
+    for (size_t i = 0; i < capacity + 10; ++i) rec.print("record {}", i);
+    // Records longer than the slot payload are truncated.
+    rec.print("{}", std::string(100, 'x'));
+  }
+  auto records = fmt::read_flight_recorder(path);
+  ASSERT_EQ(records.size(), capacity);
+  EXPECT_EQ(records.front(), fmt::format("record {}", 11));
+  EXPECT_EQ(records[capacity - 2], fmt::format("record {}", capacity + 9));
+  EXPECT_EQ(records.back(), std::string(48, 'x'));
+
+  // Reopening a recorder with the same geometry continues it.
+  {
+    auto rec = fmt::flight_recorder(path, 4096, 64);
+    rec.print("reopened");
+  }
+  records = fmt::read_flight_recorder(path);
+  ASSERT_EQ(records.size(), capacity);
+  EXPECT_EQ(records[capacity - 2], std::string(48, 'x'));
+  EXPECT_EQ(records.back(), "reopened");
+
+  // A different geometry starts a new recorder.
+  {
+    auto rec = fmt::flight_recorder(path, 4096, 128);
+    rec.print("new");
+  }
+  EXPECT_EQ(fmt::read_flight_recorder(path), std::vector<std::string>{"new"});
+  std::remove(path);
+}
+
+TEST(flight_recorder_test, threads) {
+  const char* path = "test-flight-recorder";
+  {
+    auto rec = fmt::flight_recorder(path, 1 << 20, 64);
+    auto threads = std::vector<std::thread>();
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&rec, t]() {
+        for (int i = 0; i < 1000; ++i) rec.print("{} {}", t, i);
+      });
+    }
+    for (auto& t : threads) t.join();
+  }
+  auto records = fmt::read_flight_recorder(path);
+  ASSERT_EQ(records.size(), 4000u);
+  int next[4] = {};
+  for (const auto& r : records) {
+    int t = r[0] - '0';
+    ASSERT_TRUE(t >= 0 && t < 4);
+    // Records from each thread are in order.
+    EXPECT_EQ(r, fmt::format("{} {}", t, next[t]++));
+  }
+  std::remove(path);
+}
+
+#    if GTEST_HAS_DEATH_TEST
+TEST(flight_recorder_test, crash) {
+  const char* path = "test-flight-recorder";
+  std::remove(path);
+  EXPECT_DEATH(
+      {
+        auto rec = fmt::flight_recorder(path, 4096);
+        rec.print("last words {}", 42);
+        std::abort();
+      },
+      "");
+  EXPECT_EQ(fmt::read_flight_recorder(path),
+            std::vector<std::string>{"last words 42"});
+  std::remove(path);
+}
+#    endif
+
+TEST(flight_recorder_test, invalid_file) {
+  const char* path = "test-flight-recorder";
+  {
+    auto out = fmt::output_file(path);
+    out.print("not a recorder");
+  }
+  EXPECT_THROW(fmt::read_flight_recorder(path), std::runtime_error);
+  std::remove(path);
+}
+#  endif  // FMT_USE_MMAP
+
+#  if FMT_USE_MMAP
+static auto make_file_contents_test_file(const std::string& path)
+    -> std::string {
+  auto content = std::string();
+  for (int i = 0; i < 2000; ++i) content += fmt::format("{:04} ", i);
+  auto out = file(path, file::WRONLY | file::CREATE | file::TRUNC);
+  out.write(content.data(), content.size());
+  return content;
+}
+
+TEST(file_contents_test, format) {
+  auto test_file = uniq_file_name(__LINE__);
+  auto content = make_file_contents_test_file(test_file);
+  auto f = file(test_file, file::RDONLY);
+  EXPECT_EQ(fmt::format("[{}]", fmt::file_contents(f)), "[" + content + "]");
+  EXPECT_EQ(fmt::format("{}", fmt::file_contents(f, 5, 4)), "0001");
+  EXPECT_EQ(fmt::format("{}", fmt::file_contents(f, 5000, 9)),
+            content.substr(5000, 9));
+  EXPECT_EQ(fmt::format("{}", fmt::file_contents(f, 9995)), "1999 ");
+  EXPECT_EQ(fmt::format("{}", fmt::file_contents(f, 10000)), "");
+  EXPECT_EQ(fmt::format("{}", fmt::file_contents(f, -1)), "");
+}
+
+TEST(file_contents_test, ostream) {
+  auto test_file = uniq_file_name(__LINE__);
+  auto content = make_file_contents_test_file(test_file);
+  auto f = file(test_file, file::RDONLY);
+  auto expected = "<" + content + content.substr(5001, 9000) + ">";
+  auto out_file = uniq_file_name(__LINE__);
+  fmt::output_file(out_file).print("<{}{}>", fmt::file_contents(f),
+                                   fmt::file_contents(f, 5001, 9000));
+  auto in = file(out_file, file::RDONLY);
+  EXPECT_EQ(read(in, expected.size() + 1), expected);
+
+  fmt::output_file(out_file, fmt::compress = fmt::compression::fast)
+      .print("<{}{}>", fmt::file_contents(f),
+             fmt::file_contents(f, 5001, 9000));
+  EXPECT_EQ(read_input_file(out_file), expected);
+}
+
+TEST(file_contents_test, pipe) {
+  auto test_file = uniq_file_name(__LINE__);
+  auto content = make_file_contents_test_file(test_file);
+  auto f = file(test_file, file::RDONLY);
+  auto p = fmt::pipe();
+  auto out = fmt::output_file(std::move(p.write_end));
+  out.print("{}!", fmt::file_contents(f, 0, 100));
+  out.close();
+  EXPECT_READ(p.read_end, content.substr(0, 100) + "!");
+}
+#  endif  // FMT_USE_MMAP
 #endif  // FMT_USE_FCNTL
@@ -119,6 +119,77 @@ TEST(ostream_test, print) {
   }
 }
 
+TEST(ostream_test, print_large) {
+  auto s = std::string(100000, 'x');
+  std::ostringstream os;
+  os << "a";
+  fmt::print(os, "{}{}", s, 42);
+  fmt::println(os, "{}", s);
+  EXPECT_EQ(os.str(), "a" + s + "42" + s + "\n");
+}
+
+TEST(ostream_test, print_to_streambuf_without_put_area) {
+  struct test_streambuf : std::streambuf {
+    std::string data;
+    auto overflow(int_type c) -> int_type override {
+      if (!traits_type::eq_int_type(c, traits_type::eof()))
+        data.push_back(traits_type::to_char_type(c));
+      return traits_type::not_eof(c);
+    }
+    auto xsputn(const char* s, std::streamsize n) -> std::streamsize override {
+      data.append(s, static_cast<size_t>(n));
+      return n;
+    }
+  } streambuf;
+  std::ostream os(&streambuf);
+  fmt::print(os, "{:>1000}", 42);
+  EXPECT_EQ(streambuf.data, std::string(998, ' ') + "42");
+}
+
+TEST(ostream_test, print_failure) {
+  struct failing_streambuf : std::streambuf {
+    auto xsputn(const char*, std::streamsize) -> std::streamsize override {
+      return 0;
+    }
+  } streambuf;
+  std::ostream os(&streambuf);
+  fmt::print(os, "{}", 42);
+  EXPECT_TRUE(os.bad());
+}
+
+TEST(ostream_test, print_format_error) {
+  std::ostringstream os;
+  EXPECT_THROW(fmt::print(os, runtime("{}{"), 42), fmt::format_error);
+  EXPECT_EQ(os.str(), "");
+}
+
+TEST(ostream_test, print_streambuf_exception) {
+  struct throwing_streambuf : std::streambuf {
+    auto xsputn(const char*, std::streamsize) -> std::streamsize override {
+      throw std::runtime_error("streambuf error");
+    }
+  } streambuf;
+  std::ostream os(&streambuf);
+  fmt::print(os, "{:>1000}", 42);
+  EXPECT_TRUE(os.bad());
+
+  std::ostream throwing_os(&streambuf);
+  throwing_os.exceptions(std::ios_base::badbit);
+  EXPECT_THROW(fmt::print(throwing_os, "{:>1000}", 42), std::runtime_error);
+  EXPECT_TRUE(throwing_os.bad());
+}
+
+TEST(ostream_test, print_format_error_keeps_stream_good) {
+  std::ostringstream os;
+  os << "a";
+  EXPECT_THROW(fmt::print(os, runtime("{}{"), 42), fmt::format_error);
+  // Output that doesn't fit into the put area.
+  EXPECT_THROW(fmt::print(os, runtime("{:>100000}{"), 42), fmt::format_error);
+  EXPECT_TRUE(os.good());
+  os << "b";
+  EXPECT_EQ(os.str(), "ab");
+}
+
 TEST(ostream_test, write_to_ostream) {
   std::ostringstream os;
   fmt::memory_buffer buffer;
@@ -0,0 +1,93 @@
+// Formatting library for C++ - per-call-site profiler tests
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "fmt/compile.h"
+#include "gtest/gtest.h"
+
+static_assert(FMT_PROFILE, "profile-test must be compiled with FMT_PROFILE=1");
+
+namespace {
+auto dump_profile() -> std::string {
+  FILE* f = std::tmpfile();
+  fmt::dump_profile(f);
+  std::rewind(f);
+  auto result = std::string();
+  char buf[4096];
+  while (size_t n = std::fread(buf, 1, sizeof(buf), f)) result.append(buf, n);
+  std::fclose(f);
+  return result;
+}
+
+// Returns the line of the profile containing `text`.
+auto find_line(const std::string& profile, const std::string& text)
+    -> std::string {
+  auto pos = profile.find(text);
+  if (pos == std::string::npos) return {};
+  auto begin = profile.rfind('\n', pos) + 1;
+  return profile.substr(begin, profile.find('\n', pos) - begin);
+}
+}  // namespace
+
+TEST(profile_test, call_sites) {
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(fmt::format("profile-test {}", 42), "profile-test 42");
+    if (i % 10 == 0)
+      EXPECT_EQ(fmt::format("profile-{}-site", 1), "profile-1-site");
+  }
+  auto profile = dump_profile();
+  auto header = profile.substr(0, profile.find('\n'));
+  EXPECT_NE(header.find("calls"), std::string::npos);
+  EXPECT_NE(header.find("format string"), std::string::npos);
+
+  auto line = find_line(profile, "\"profile-test {}\"");
+  EXPECT_NE(line.find(" 100 "), std::string::npos) << line;
+  EXPECT_NE(line.find(" 1500 "), std::string::npos) << line;
+  line = find_line(profile, "\"profile-{}-site\"");
+  EXPECT_NE(line.find(" 10 "), std::string::npos) << line;
+  // Sites are sorted by the total cost.
+  EXPECT_LT(profile.find("profile-test"), profile.find("profile-{}-site"));
+}
+
+TEST(profile_test, threads) {
+  auto format = [] {
+    for (int i = 0; i < 50; ++i) (void)fmt::format("thread-site {}", i);
+  };
+  std::thread(format).join();
+  std::thread(format).join();
+  format();
+  auto line = find_line(dump_profile(), "\"thread-site {}\"");
+  EXPECT_NE(line.find(" 150 "), std::string::npos) << line;
+}
+
+TEST(profile_test, long_format_string) {
+  (void)fmt::format(
+      "a very long format string that doesn't fit in the profile entry {}", 1);
+  auto line = find_line(dump_profile(), "\"a very long format string");
+  EXPECT_NE(line.find("\"..."), std::string::npos) << line;
+}
+
+#ifdef __cpp_if_constexpr
+TEST(profile_test, compiled_format) {
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(fmt::format(FMT_COMPILE("compiled-site {}"), 42),
+              "compiled-site 42");
+    char buf[32];
+    auto end = fmt::format_to(buf, FMT_COMPILE("compiled-to {}"), 42);
+    EXPECT_EQ(std::string(buf, end), "compiled-to 42");
+  }
+  auto profile = dump_profile();
+  auto line = find_line(profile, "\"compiled-site {}\"");
+  EXPECT_NE(line.find(" 5 "), std::string::npos) << line;
+  EXPECT_NE(line.find(" 80 "), std::string::npos) << line;
+  line = find_line(profile, "\"compiled-to {}\"");
+  EXPECT_NE(line.find(" 70 "), std::string::npos) << line;
+}
+#endif
@@ -0,0 +1,147 @@
+// Formatting library for C++ - formatting statistics tests
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "fmt/os.h"
+#include "gtest-extra.h"
+#include "gtest/gtest.h"
+#include "util.h"
+
+static_assert(FMT_STATS, "stats-test must be compiled with FMT_STATS=1");
+
+namespace {
+const char* test_file = "stats-test.tmp";
+}  // namespace
+
+TEST(stats_test, format_calls) {
+  auto before = fmt::thread_stats();
+  EXPECT_EQ(fmt::format("{}", 42), "42");
+  EXPECT_EQ(fmt::format("{}{}", "a", 'b'), "ab");
+  auto after = fmt::thread_stats();
+  EXPECT_EQ(after.format_calls - before.format_calls, 2);
+  EXPECT_EQ(after.allocations, before.allocations);
+  EXPECT_EQ(after.buffer_grows, before.buffer_grows);
+}
+
+TEST(stats_test, buffer_grows) {
+  auto before = fmt::thread_stats();
+  auto s = fmt::format("{}", std::string(1000, 'x'));
+  auto after = fmt::thread_stats();
+  EXPECT_EQ(after.buffer_grows - before.buffer_grows, 1);
+  EXPECT_EQ(after.buffer_grow_bytes - before.buffer_grow_bytes, 1000);
+  // One allocation by the buffer and one by the result.
+  EXPECT_EQ(after.allocations - before.allocations, 2);
+}
+
+TEST(stats_test, float) {
+  auto before = fmt::thread_stats();
+  EXPECT_EQ(fmt::format("{}", 0.1), "0.1");
+  EXPECT_EQ(fmt::format("{:.3f}", 0.1), "0.100");
+  auto after = fmt::thread_stats();
+  EXPECT_EQ(after.float_fast_path - before.float_fast_path, 2);
+  EXPECT_EQ(after.float_dragon_fallbacks, before.float_dragon_fallbacks);
+
+  before = after;
+  EXPECT_EQ(fmt::format("{:.30f}", 0.1),
+            "0.100000000000000005551115123126");
+  after = fmt::thread_stats();
+  EXPECT_EQ(after.float_dragon_fallbacks - before.float_dragon_fallbacks, 1);
+}
+
+TEST(stats_test, locale_lookups) {
+  auto before = fmt::thread_stats();
+  EXPECT_EQ(fmt::format("{:L}", 1000), "1000");
+  EXPECT_EQ(fmt::thread_stats().locale_lookups - before.locale_lookups, 1);
+}
+
+TEST(stats_test, file_locks) {
+  auto before = fmt::thread_stats();
+  {
+    auto f = fmt::buffered_file(test_file, "w");
+    fmt::print(f.get(), "{}", 42);
+    fmt::println(f.get(), "{}", 42);
+  }
+  EXPECT_EQ(fmt::thread_stats().file_locks - before.file_locks, 2);
+  std::remove(test_file);
+}
+
+#if FMT_USE_FCNTL
+TEST(stats_test, ostream_flushes) {
+  auto before = fmt::thread_stats();
+  {
+    auto out = fmt::output_file(test_file);
+    out.print("{}", 42);
+    out.flush();
+    out.flush();  // Empty flushes are not counted.
+    out.print("{}", 42);
+  }
+  EXPECT_EQ(fmt::thread_stats().ostream_flushes - before.ostream_flushes, 2);
+  std::remove(test_file);
+}
+#endif
+
+TEST(stats_test, aggregate_threads) {
+  auto before = fmt::stats();
+  auto thread_calls = fmt::format_stats();
+  std::thread([&] {
+    EXPECT_EQ(fmt::format("{}", 1), "1");
+    EXPECT_EQ(fmt::format("{}", 2), "2");
+    thread_calls = fmt::thread_stats();
+  }).join();
+  EXPECT_EQ(thread_calls.format_calls, 2);
+  // Counters of the exited thread are retained.
+  EXPECT_EQ(fmt::stats().format_calls - before.format_calls, 2);
+
+  // A new thread starts with zero counters.
+  std::thread([&] { thread_calls = fmt::thread_stats(); }).join();
+  EXPECT_EQ(thread_calls.format_calls, 0);
+}
+
+TEST(stats_test, monotonic_with_thread_exits) {
+  auto done = std::atomic<bool>(false);
+  auto spawner = std::thread([&] {
+    for (int i = 0; i < 200; ++i) {
+      std::thread([] { (void)fmt::format("{}", 42); }).join();
+    }
+    done = true;
+  });
+  auto last = fmt::stats().format_calls;
+  auto decreased = false;
+  while (!done) {
+    auto calls = fmt::stats().format_calls;
+    if (calls < last) decreased = true;
+    last = calls;
+  }
+  spawner.join();
+  EXPECT_FALSE(decreased);
+  EXPECT_GE(fmt::stats().format_calls, last);
+}
+
+// Formats in the destructor which runs after the stats of the thread have
+// been released if the object is constructed before the first format call.
+struct format_on_exit {
+  ~format_on_exit() { (void)fmt::format("{}", 42); }
+};
+
+TEST(stats_test, format_on_thread_exit) {
+  auto before = fmt::stats();
+  std::thread([] {
+    static thread_local format_on_exit obj;
+    (void)obj;
+    EXPECT_EQ(fmt::format("{}", 1), "1");
+  }).join();
+  EXPECT_EQ(fmt::stats().format_calls - before.format_calls, 2);
+
+  // The released block is not updated after it has been reset.
+  auto thread_calls = fmt::format_stats();
+  std::thread([&] { thread_calls = fmt::thread_stats(); }).join();
+  EXPECT_EQ(thread_calls.format_calls, 0);
+}
@@ -10,6 +10,7 @@
 #include <bitset>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "fmt/os.h"       // fmt::system_category
@@ -31,6 +32,10 @@ TEST(std_test, path) {
   EXPECT_EQ(fmt::format("{}", path("foo\"bar")), "foo\"bar");
   EXPECT_EQ(fmt::format("{:?}", path("foo\"bar")), "\"foo\\\"bar\"");
 
+  EXPECT_EQ(fmt::format("{:>7?}", path("foo")), "  \"foo\"");
+  EXPECT_EQ(fmt::format("{:*^{}?}", path("a\nb"), 10), "**\"a\\nb\"**");
+  EXPECT_EQ(fmt::format("{:<6g}", path("/usr")), "/usr  ");
+
   EXPECT_EQ(fmt::format("{:g}", path("/usr/bin")), "/usr/bin");
 #  ifdef _WIN32
   EXPECT_EQ(fmt::format("{}", path("C:\\foo")), "C:\\foo");
@@ -402,6 +407,48 @@ TEST(std_test, type_info) {
   EXPECT_EQ(fmt::format("{}", typeid(std::runtime_error)),
             "std::runtime_error");
 }
+
+TEST(std_test, type_info_cached) {
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(fmt::format("{}", typeid(std::logic_error)), "std::logic_error");
+    EXPECT_EQ(fmt::format("{:t}", std::range_error("x")),
+              "std::range_error: x");
+  }
+  auto threads = std::vector<std::thread>();
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([] {
+      for (int j = 0; j < 100; ++j) {
+        EXPECT_EQ(fmt::format("{}", typeid(std::out_of_range)),
+                  "std::out_of_range");
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+}
+
+TEST(std_test, type_name_cache) {
+  static fmt::detail::type_name_cache cache;
+  char key[] = "key";
+  auto name = std::string("name");
+  EXPECT_EQ(*cache.insert(key, name), "name");
+  EXPECT_EQ(*cache.find(key), "name");
+  // A different name at the same address is not matched.
+  key[0] = 'x';
+  EXPECT_EQ(cache.find(key), nullptr);
+
+  // Insertion stops once the cache is full and leaves the name intact.
+  static char keys[1024][8];
+  auto n = 0;
+  for (auto& k : keys) {
+    name = "name";
+    if (!cache.insert(k, name)) break;
+    ++n;
+  }
+  EXPECT_LT(n, 1024);
+  EXPECT_EQ(name, "name");
+  EXPECT_EQ(cache.insert(keys[1023], name), nullptr);
+  EXPECT_EQ(name, "name");
+}
 #endif
 
 TEST(std_test, format_bit_reference) {
@@ -423,6 +470,38 @@ TEST(std_test, format_bitset) {
   EXPECT_EQ(fmt::format("{}", bs), "101010");
   EXPECT_EQ(fmt::format("{:0>8}", bs), "00101010");
   EXPECT_EQ(fmt::format("{:-^12}", bs), "---101010---");
+
+  auto large = std::bitset<200>();
+  large.set(0).set(63).set(64).set(130).set(199);
+  auto expected = std::string(200, '0');
+  for (size_t pos : {0, 63, 64, 130, 199}) expected[199 - pos] = '1';
+  EXPECT_EQ(fmt::format("{}", large), expected);
+  EXPECT_EQ(fmt::format("{:>202}", large), "  " + expected);
+  auto out = std::string(200, ' ');
+  fmt::format_to(&out[0], "{}", large);
+  EXPECT_EQ(out, expected);
+  EXPECT_EQ(fmt::format("{}", std::bitset<64>(~0ull)), std::string(64, '1'));
+  EXPECT_EQ(fmt::format("{}", std::bitset<0>()), "");
+
+  // Larger than the bulk extraction limit.
+  auto huge = std::bitset<5000>();
+  for (size_t pos = 0; pos < huge.size(); pos += pos % 7 + 1) huge.set(pos);
+  EXPECT_EQ(fmt::format("{}", huge), huge.to_string());
+}
+
+TEST(std_test, format_bits) {
+  uint64_t words[] = {0x8000000000000005, 0xf0};
+  auto expected = std::string(128, '0');
+  for (size_t pos : {0, 2, 63, 68, 69, 70, 71}) expected[127 - pos] = '1';
+  EXPECT_EQ(fmt::format("{}", fmt::bits(words, 2)), expected);
+  EXPECT_EQ(fmt::format("{:*>{}}", fmt::bits(words, 2), 130),
+            "**" + expected);
+  EXPECT_EQ(fmt::format("{:^66}", fmt::bits(std::vector<uint64_t>{1})),
+            " " + std::string(63, '0') + "1 ");
+  EXPECT_EQ(fmt::format("{}", fmt::bits(words, 0)), "");
+  auto v = std::vector<char>();
+  fmt::format_to(std::back_inserter(v), "{}", fmt::bits(words, 1));
+  EXPECT_EQ(std::string(v.data(), v.size()), expected.substr(64));
 }
 
 TEST(std_test, format_atomic) {
@@ -0,0 +1,97 @@
+// Formatting library for C++ - aligned table tests
+//
+// Copyright (c) 2012 - present, Victor Zverovich
+// All rights reserved.
+//
+// For the license information refer to format.h.
+
+#include "fmt/table.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+TEST(table_test, empty) {
+  auto t = fmt::table();
+  EXPECT_EQ(fmt::format("{}", t), "");
+  EXPECT_EQ(t.num_rows(), 0);
+}
+
+TEST(table_test, default_alignment) {
+  auto t = fmt::table();
+  t.add_row("name", "size");
+  t.add_row("a.txt", 42);
+  t.add_row("longer.txt", 1234);
+  EXPECT_EQ(fmt::format("{}", t),
+            "name        size\n"
+            "a.txt         42\n"
+            "longer.txt  1234\n");
+  EXPECT_EQ(t.num_rows(), 3);
+}
+
+TEST(table_test, column_alignment) {
+  auto t = fmt::table(" | ");
+  t.set_align(0, fmt::align::right);
+  t.set_align(1, fmt::align::center);
+  t.set_align(2, fmt::align::left);
+  t.add_row("x", "ab", 1.5);
+  t.add_row("yyy", "abcdef", 10);
+  t.add_row("zz", "a", "");
+  EXPECT_EQ(fmt::format("{}", t),
+            "  x |   ab   | 1.5\n"
+            "yyy | abcdef | 10\n"
+            " zz |   a    | \n");
+}
+
+TEST(table_test, add_cell) {
+  auto t = fmt::table();
+  t.add_cell("{:.2f}", 3.14159);
+  t.add_cell("{}-{}", 'a', 'b');
+  t.end_row();
+  t.add_cell("{}", 1);
+  t.end_row();
+  EXPECT_EQ(fmt::format("{}", t), "3.14  a-b\n1\n");
+}
+
+TEST(table_test, unicode_width) {
+  auto t = fmt::table();
+  t.add_row("\xe4\xb8\xad\xe6\x96\x87", 1);  // Two wide characters.
+  t.add_row("abcde", 2);
+  EXPECT_EQ(fmt::format("{}", t),
+            "\xe4\xb8\xad\xe6\x96\x87   1\n"
+            "abcde  2\n");
+}
+
+TEST(table_test, blocks) {
+  auto t = fmt::table();
+  t.add_row("long value", 1);
+  auto first = fmt::format("{}", t);
+  t.clear();
+  EXPECT_EQ(t.num_rows(), 0);
+  t.add_row("x", 2);
+  EXPECT_EQ(first + fmt::format("{}", t),
+            "long value  1\n"
+            "x           2\n");
+}
+
+TEST(table_test, min_width) {
+  auto t = fmt::table();
+  t.set_min_width(0, 6);
+  t.set_min_width(1, 3);
+  t.add_row("a", 1);
+  auto first = fmt::format("{}", t);
+  t.clear();
+  t.add_row("abcdef", 100);
+  EXPECT_EQ(first + fmt::format("{}", t),
+            "a         1\n"
+            "abcdef  100\n");
+}
+
+TEST(table_test, format_to) {
+  auto t = fmt::table();
+  t.add_row(1, 22);
+  t.add_row(333, 4);
+  auto s = std::string();
+  fmt::format_to(std::back_inserter(s), "{}", t);
+  EXPECT_EQ(s, "  1  22\n333   4\n");
+}